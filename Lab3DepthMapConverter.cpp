@@ -5,14 +5,28 @@
 #include <filesystem>
 
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
 #include <windows.h>
 #endif
 
 #include "config_reader.h"
 #include "depth_reader.h"
 #include "mesh_exporter.h"
+#include "mesh_importer.h"
 #include "opengl_visualizer.h"
 #include "bmp_saver.h"
+#include "depth_image_saver.h"
+#include "software_renderer.h"
+#include "lighting_benchmark.h"
+#include "sweep_renderer.h"
+#include "ray_caster.h"
+#include "heightfield.h"
+#include "output_sink.h"
 
 namespace fs = std::filesystem;
 namespace fs = std::filesystem;
@@ -42,7 +56,7 @@ int main(int argc, char** argv) {
     // 1. Проверка аргументов командной строки
     if (argc < 2) {
         std::cerr << "Ошибка: Не указан JSON файл конфигурации" << std::endl;
-        std::cerr << "Использование: " << argv[0] << " <config.json>" << std::endl;
+        std::cerr << "Использование: " << argv[0] << " <config.json> [--bench-lut]" << std::endl;
         std::cerr << "Пример: " << argv[0] << " config.json" << std::endl;
         std::cerr << "Пример: " << argv[0] << " config_lambert.json" << std::endl;
         std::cerr << "Пример: " << argv[0] << " config_phong.json" << std::endl;
@@ -61,9 +75,20 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    // Замер табличного освещения против аналитического вместо обработки
+    if (argc > 2 && std::string(argv[2]) == "--bench-lut") {
+        LightingBenchmark::run(config);
+        return 0;
+    }
+
     // 3. Создание выходной директории
     createOutputDirectory(config.output_dir);
 
+    // Все экспортеры и BMPSaver пишут через выбранный приемник
+    OutputSink::setDefaultBackend(
+        config.output_backend == "async" ? OutputSink::ASYNC : OutputSink::STREAM,
+        config.output_direct_io);
+
     // 4. Чтение карты глубины
     std::cout << "\n2. Чтение карты глубины..." << std::endl;
     DepthReader reader;
@@ -76,11 +101,49 @@ int main(int argc, char** argv) {
     std::cout << "Размер карты глубины: " << reader.getWidth()
         << "x" << reader.getHeight() << std::endl;
 
-    // 5. Сохранение карты глубины как BMP
+    // 5. Сохранение карты глубины как изображения: диапазон считается один
+    // раз для всех форматов
     std::cout << "\n3. Сохранение карты глубины как изображения..." << std::endl;
-    std::string depthBMP = config.output_dir + "/depth_map.bmp";
-    if (BMPSaver::saveDepthMapAsBMP(depthData, depthBMP)) {
-        std::cout << "Карта глубины сохранена: " << depthBMP << std::endl;
+    DepthNormalization normalization;
+    if (!config.depth_image_formats.empty()) {
+        const DepthNormalization::Mode mode = DepthNormalization::modeFromName(config.depth_normalization);
+        if (normalization.compute(depthData, mode, config.depth_percentile_low, config.depth_percentile_high)) {
+            std::cout << "Диапазон глубины: " << normalization.getMinDepth()
+                << " - " << normalization.getMaxDepth();
+            if (mode == DepthNormalization::PERCENTILE) {
+                std::cout << ", после обрезки по процентилям: " << normalization.getLowDepth()
+                    << " - " << normalization.getHighDepth();
+            }
+            else if (mode == DepthNormalization::EQUALIZE) {
+                std::cout << ", выравнивание гистограммы";
+            }
+            std::cout << std::endl;
+        }
+        else {
+            std::cout << "Карта глубины содержит только фон" << std::endl;
+        }
+    }
+    for (const auto& format : config.depth_image_formats) {
+        const std::string depthImage = config.output_dir + "/depth_map.";
+        bool saved = false;
+        if (format == "bmp" || format == "BMP") {
+            saved = BMPSaver::saveDepthMapAsBMP(depthData, normalization, depthImage + "bmp", config.depth_bmp_palette);
+        }
+        else if (format == "pgm" || format == "PGM") {
+            saved = DepthImageSaver::savePGM(depthData, normalization, depthImage + "pgm");
+        }
+        else if (format == "pfm" || format == "PFM") {
+            saved = DepthImageSaver::savePFM(depthData, depthImage + "pfm");
+        }
+        else if (format == "png" || format == "PNG") {
+            saved = DepthImageSaver::savePNG(depthData, normalization, depthImage + "png", config.depth_png_deflate);
+        }
+        else {
+            std::cerr << "Неизвестный формат изображения карты глубины: " << format << std::endl;
+        }
+        if (!saved) {
+            std::cerr << "Ошибка сохранения карты глубины в формате " << format << std::endl;
+        }
     }
 
     // 6. Экспорт в разные форматы
@@ -90,13 +153,26 @@ int main(int argc, char** argv) {
         std::unique_ptr<MeshExporter> exporter;
 
         if (format == "obj" || format == "OBJ") {
-            exporter = std::make_unique<OBJExporter>();
+            exporter = std::make_unique<OBJExporter>(config.mesh_normals, config.mesh_double);
         }
         else if (format == "stl" || format == "STL") {
-            exporter = std::make_unique<STLExporter>();
+            exporter = std::make_unique<STLExporter>(config.mesh_binary);
         }
         else if (format == "ply" || format == "PLY") {
-            exporter = std::make_unique<PLYExporter>();
+            exporter = std::make_unique<PLYExporter>(config.mesh_binary,
+                config.ply_normals, config.mesh_double);
+        }
+        else if (format == "points" || format == "POINTS") {
+            exporter = std::make_unique<PointCloudExporter>(PointCloudExporter::BINARY_PLY,
+                config.pointcloud_stride, config.pointcloud_voxel);
+        }
+        else if (format == "xyz" || format == "XYZ") {
+            exporter = std::make_unique<PointCloudExporter>(PointCloudExporter::XYZ,
+                config.pointcloud_stride, config.pointcloud_voxel);
+        }
+        else if (format == "xyzn" || format == "XYZN") {
+            exporter = std::make_unique<PointCloudExporter>(PointCloudExporter::XYZN,
+                config.pointcloud_stride, config.pointcloud_voxel);
         }
         else {
             std::cerr << "Неизвестный формат: " << format << std::endl;
@@ -108,13 +184,78 @@ int main(int argc, char** argv) {
 
         if (exporter->exportMesh(depthData, outputFile, config.scale)) {
             std::cout << "  Успешно: " << outputFile << std::endl;
+
+            // Контрольное чтение только что записанного файла
+            if (config.verify_exports && MeshImporter::isSupported(outputFile)) {
+                Mesh mesh;
+                if (!MeshImporter::importMesh(outputFile, mesh)) {
+                    std::cerr << "  Ошибка проверки: файл не читается " << outputFile << std::endl;
+                }
+            }
         }
         else {
             std::cerr << "  Ошибка экспорта в " << exporter->getFormatName() << std::endl;
         }
     }
 
-    // 7. Визуализация в OpenGL
+    // Карта фонового затенения: серое изображение в разрешении карты
+    // глубины или сетка с цветами вершин
+    if (config.ambient_occlusion && !config.ao_output.empty()) {
+        std::cout << "\nФоновое затенение (" << config.ao_directions << " направлений)..." << std::endl;
+        std::vector<float> occlusion;
+        const Heightfield field = Heightfield::fromDepth(depthData, config.scale);
+        HeightfieldLighting::ambientOcclusion(field, config.ao_directions, config.ao_radius, occlusion);
+
+        for (const auto& path : config.ao_output) {
+            const std::string ext = fs::path(path).extension().string();
+            bool saved = false;
+            if (ext == ".ply" || ext == ".PLY") {
+                PLYExporter exporter(config.mesh_binary, config.ply_normals, config.mesh_double);
+                exporter.setVertexShade(&occlusion);
+                saved = exporter.exportMesh(depthData, path, config.scale);
+            }
+            else if (ext == ".bmp" || ext == ".BMP") {
+                std::vector<uint8_t> pixels(occlusion.size() * 3, 0);
+                for (size_t k = 0; k < occlusion.size(); ++k) {
+                    if (!field.valid[k]) continue;
+                    const uint8_t value = static_cast<uint8_t>(occlusion[k] * 255.0f + 0.5f);
+                    pixels[k * 3] = pixels[k * 3 + 1] = pixels[k * 3 + 2] = value;
+                }
+                saved = BMPSaver::saveFrameBuffer(path, field.cols, field.rows, pixels);
+            }
+            else {
+                std::cerr << "Неизвестный формат карты затенения: " << path << std::endl;
+                continue;
+            }
+            if (saved) std::cout << "  Карта затенения сохранена: " << path << std::endl;
+            else std::cerr << "  Ошибка сохранения карты затенения: " << path << std::endl;
+        }
+    }
+
+    // 7. Безоконный рендер на CPU или через OpenGL без дисплея
+    if (config.render_mode == "software" || config.render_mode == "relight"
+        || config.render_mode == "sweep" || config.render_mode == "raycast"
+        || config.render_mode == "offscreen") {
+        std::cout << (config.render_mode == "offscreen"
+            ? "\n5. Рендер изображения OpenGL без окна..." : "\n5. Рендер изображения на CPU...") << std::endl;
+        const std::string imageDir = fs::path(config.image_output).parent_path().string();
+        if (!imageDir.empty()) {
+            createOutputDirectory(imageDir);
+        }
+        bool rendered = false;
+        if (config.render_mode == "relight") rendered = SoftwareRenderer::relightToFile(depthData, config);
+        else if (config.render_mode == "sweep") rendered = SweepRenderer::run(depthData, config);
+        else if (config.render_mode == "raycast") rendered = RayCaster::renderToFile(depthData, config);
+        else if (config.render_mode == "offscreen") rendered = OpenGLVisualizer::renderOffscreen(std::move(depthData), config);
+        else rendered = SoftwareRenderer::renderToFile(depthData, config);
+        if (!rendered) {
+            std::cerr << "Ошибка рендера изображения!" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    // 8. Визуализация в OpenGL
     std::cout << "\n5. Запуск OpenGL визуализации..." << std::endl;
     std::cout << "Используется модель отражения: ";
     switch (config.reflection_model) {
@@ -123,8 +264,8 @@ int main(int argc, char** argv) {
     case 2: std::cout << "Торренса-Сперроу" << std::endl; break;
     }
 
-    // Инициализация OpenGL
-    OpenGLVisualizer::initialize(argc, argv, depthData, config);
+    // Инициализация OpenGL; карта больше не нужна здесь и передается без копирования
+    OpenGLVisualizer::initialize(argc, argv, std::move(depthData), config);
 
     // Запуск основного цикла
     OpenGLVisualizer::run();
@@ -1,6 +1,10 @@
 #include "bmp_saver.h"
-#include <fstream>
+#include "mapped_file.h"
+#include "parallel_utils.h"
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
 #include <vector>
 #include <cstdint>
 #include <algorithm>
@@ -30,35 +34,83 @@ struct BMPInfoHeader {
 };
 #pragma pack(pop)
 
-bool BMPSaver::saveFrameBuffer(const std::string& filename,
-    int width, int height) {
-    //      
-    std::cout << "[INFO] BMPSaver::saveFrameBuffer - \n";
+std::vector<uint8_t> BMPSaver::flipRows(const std::vector<uint8_t>& pixels, int width, int height) {
+    const size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> flipped(stride * height);
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(flipped.data() + static_cast<size_t>(y) * stride,
+            pixels.data() + static_cast<size_t>(height - 1 - y) * stride, stride);
+    }
+    return flipped;
+}
+
+std::string BMPSaver::outputStem(const std::string& imageOutput) {
+    const size_t dot = imageOutput.find_last_of('.');
+    const size_t slash = imageOutput.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        return imageOutput.substr(0, dot);
+    }
+    return imageOutput;
+}
+
+std::string BMPSaver::framePath(const std::string& imageOutput, int frame) {
+    std::ostringstream path;
+    path << outputStem(imageOutput) << "_" << std::setw(4) << std::setfill('0') << frame << ".bmp";
+    return path.str();
+}
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << ":     " << filename << std::endl;
+bool BMPSaver::saveFrameBuffer(const std::string& filename,
+    int width, int height, const std::vector<uint8_t>& pixels) {
+    if (width <= 0 || height <= 0 ||
+        pixels.size() != static_cast<size_t>(width) * height * 3) {
+        std::cerr << ":    " << width << "x" << height << std::endl;
         return false;
     }
 
-    //  BMP   
     BMPFileHeader file_header;
     BMPInfoHeader info_header;
 
     info_header.width = width;
     info_header.height = height;
-    info_header.size_image = width * height * 3;
+
+    //    4 
+    int row_stride = width * 3;
+    int padding = (4 - (row_stride % 4)) % 4;
+    info_header.size_image = (row_stride + padding) * height;
+
     file_header.file_size = sizeof(file_header) + sizeof(info_header) + info_header.size_image;
+    file_header.offset_data = sizeof(file_header) + sizeof(info_header);
 
-    //  
-    file.write(reinterpret_cast<char*>(&file_header), sizeof(file_header));
-    file.write(reinterpret_cast<char*>(&info_header), sizeof(info_header));
+    MappedFile file;
+    if (!file.create(filename, file_header.file_size)) {
+        return false;
+    }
 
-    //   
-    std::vector<uint8_t> pixels(width * height * 3, 0);
-    file.write(reinterpret_cast<char*>(pixels.data()), pixels.size());
+    char* base = file.data();
+    std::memcpy(base, &file_header, sizeof(file_header));
+    std::memcpy(base + sizeof(file_header), &info_header, sizeof(info_header));
+    uint8_t* pixelBase = reinterpret_cast<uint8_t*>(base + file_header.offset_data);
+
+    // RGB   -> BGR  
+    parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uint8_t* src = pixels.data() + static_cast<size_t>(y) * row_stride;
+            uint8_t* rowBuffer = pixelBase + static_cast<size_t>(height - 1 - y) * (row_stride + padding);
+            for (int x = 0; x < width; ++x) {
+                rowBuffer[x * 3 + 0] = src[x * 3 + 2];
+                rowBuffer[x * 3 + 1] = src[x * 3 + 1];
+                rowBuffer[x * 3 + 2] = src[x * 3 + 0];
+            }
+            for (int p = 0; p < padding; ++p) {
+                rowBuffer[row_stride + p] = 0;
+            }
+        }
+    }, 16);
 
-    file.close();
+    if (!file.close()) {
+        std::cerr << "    " << filename << std::endl;
+        return false;
+    }
     std::cout << " BMP : " << filename
         << " (" << width << "x" << height << ")" << std::endl;
 
@@ -66,7 +118,7 @@ bool BMPSaver::saveFrameBuffer(const std::string& filename,
 }
 
 bool BMPSaver::saveDepthMapAsBMP(const std::vector<std::vector<double>>& depthData,
-    const std::string& filename) {
+    const DepthNormalization& normalization, const std::string& filename, bool palette) {
     if (depthData.empty()) {
         std::cerr << ":   " << std::endl;
         return false;
@@ -79,29 +131,8 @@ bool BMPSaver::saveDepthMapAsBMP(const std::vector<std::vector<double>>& depthDa
     if (width == 0) return false;
 
     std::cout << "    BMP: "
-        << filename << " (" << width << "x" << height << ")" << std::endl;
-
-    //      
-    double minDepth = depthData[0][0];
-    double maxDepth = depthData[0][0];
-
-    for (const auto& row : depthData) {
-        for (double depth : row) {
-            if (depth > 0.0) { //   (0   )
-                if (depth < minDepth) minDepth = depth;
-                if (depth > maxDepth) maxDepth = depth;
-            }
-        }
-    }
-
-    std::cout << " : " << minDepth << " - " << maxDepth << std::endl;
-
-    //  BMP 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << ":     " << filename << std::endl;
-        return false;
-    }
+        << filename << " (" << width << "x" << height
+        << (palette ? ", 8   " : "") << ")" << std::endl;
 
     //   BMP
     BMPFileHeader file_header;
@@ -111,104 +142,68 @@ bool BMPSaver::saveDepthMapAsBMP(const std::vector<std::vector<double>>& depthDa
     info_header.width = width;
     info_header.height = height;
 
+    // 8 :     256  ,   
+    const int bytes_per_pixel = palette ? 1 : 3;
+    const uint32_t palette_size = palette ? 256 * 4 : 0;
+    info_header.bit_count = static_cast<uint16_t>(bytes_per_pixel * 8);
+    info_header.colors_used = palette ? 256 : 0;
+
     //    4 
-    int row_stride = width * 3;
+    int row_stride = width * bytes_per_pixel;
     int padding = (4 - (row_stride % 4)) % 4;
     info_header.size_image = (row_stride + padding) * height;
 
-    file_header.file_size = sizeof(file_header) + sizeof(info_header) + info_header.size_image;
-    file_header.offset_data = sizeof(file_header) + sizeof(info_header);
-
-    //  
-    file.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
-    file.write(reinterpret_cast<const char*>(&info_header), sizeof(info_header));
+    file_header.offset_data = sizeof(file_header) + sizeof(info_header) + palette_size;
+    file_header.file_size = file_header.offset_data + info_header.size_image;
 
-    //    ( ,   BMP)
-    for (int y = height - 1; y >= 0; --y) {
-        for (int x = 0; x < width; ++x) {
-            double depth = depthData[y][x];
+    //  BMP        
+    MappedFile file;
+    if (!file.create(filename, file_header.file_size)) {
+        return false;
+    }
 
-            //     0-255
-            uint8_t intensity = 0;
-            if (depth > 0.0 && maxDepth > minDepth) {
-                double normalized = (depth - minDepth) / (maxDepth - minDepth);
-                intensity = static_cast<uint8_t>(normalized * 255);
+    //     (B, G, R, 0)
+    char* base = file.data();
+    std::memcpy(base, &file_header, sizeof(file_header));
+    std::memcpy(base + sizeof(file_header), &info_header, sizeof(info_header));
+    uint8_t* paletteBase = reinterpret_cast<uint8_t*>(base + sizeof(file_header) + sizeof(info_header));
+    for (uint32_t i = 0; i < palette_size / 4; ++i) {
+        const uint8_t entry[4] = { uint8_t(i), uint8_t(i), uint8_t(i), 0 };
+        std::memcpy(paletteBase + i * 4, entry, 4);
+    }
+    uint8_t* pixelBase = reinterpret_cast<uint8_t*>(base + file_header.offset_data);
+
+    //    ,     
+    // ( ,   BMP)
+    parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        std::vector<uint8_t> gray(palette ? 0 : width);
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            uint8_t* rowBuffer = pixelBase + static_cast<size_t>(height - 1 - y) * (row_stride + padding);
+            if (palette) {
+                normalization.toGray8(depthData[y].data(), width, rowBuffer);
+            }
+            else {
+                // BMP     BGR,     
+                normalization.toGray8(depthData[y].data(), width, gray.data());
+                for (int x = 0; x < width; ++x) {
+                    rowBuffer[x * 3 + 0] = gray[x];
+                    rowBuffer[x * 3 + 1] = gray[x];
+                    rowBuffer[x * 3 + 2] = gray[x];
+                }
             }
 
-            // BMP     BGR
-            uint8_t pixel[3] = { intensity, intensity, intensity }; // grayscale
-
-            //     :
-            // uint8_t pixel[3];
-            // if (depth <= 0.0) {
-            //     pixel[0] = 0; pixel[1] = 0; pixel[2] = 0; //   
-            // } else {
-            //     //     ()   ()
-            //     double normalized = (depth - minDepth) / (maxDepth - minDepth);
-            //     if (normalized < 0.5) {
-            //         pixel[0] = static_cast<uint8_t>(normalized * 2 * 255); // blue
-            //         pixel[1] = 0;
-            //         pixel[2] = static_cast<uint8_t>((1 - normalized * 2) * 255); // red
-            //     } else {
-            //         pixel[0] = 255;
-            //         pixel[1] = static_cast<uint8_t>((normalized - 0.5) * 2 * 255); // green
-            //         pixel[2] = 0;
-            //     }
-            // }
-
-            file.write(reinterpret_cast<const char*>(pixel), 3);
+            //  
+            for (int p = 0; p < padding; ++p) {
+                rowBuffer[row_stride + p] = 0;
+            }
         }
+    }, 16);
 
-        //  
-        uint8_t padding_byte[3] = { 0, 0, 0 };
-        file.write(reinterpret_cast<const char*>(padding_byte), padding);
+    if (!file.close()) {
+        std::cerr << "    " << filename << std::endl;
+        return false;
     }
 
-    file.close();
-
     std::cout << "    BMP: " << filename << std::endl;
     return true;
 }
-
-void BMPSaver::normalizeDepthData(const std::vector<std::vector<double>>& depthData,
-    std::vector<uint8_t>& pixels) {
-    if (depthData.empty()) return;
-
-    int height = static_cast<int>(depthData.size());
-    int width = static_cast<int>(depthData[0].size());
-
-    //  /  ( )
-    double minVal = std::numeric_limits<double>::max();
-    double maxVal = std::numeric_limits<double>::lowest();
-
-    for (const auto& row : depthData) {
-        for (double val : row) {
-            if (val > 0.0) { //  
-                if (val < minVal) minVal = val;
-                if (val > maxVal) maxVal = val;
-            }
-        }
-    }
-
-    //    
-    if (minVal > maxVal) {
-        minVal = 0.0;
-        maxVal = 1.0;
-    }
-
-    //     
-    pixels.resize(width * height);
-
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            double val = depthData[i][j];
-            if (val <= 0.0) {
-                pixels[i * width + j] = 0; //   
-            }
-            else {
-                double normalized = (val - minVal) / (maxVal - minVal);
-                pixels[i * width + j] = static_cast<uint8_t>(normalized * 255);
-            }
-        }
-    }
-}
\ No newline at end of file
@@ -1,15 +1,28 @@
 #pragma once
 
+#include "depth_normalization.h"
 #include <string>
 #include <vector>
+#include <cstdint>
 
 class BMPSaver {
 public:
+    // pixels - RGB,   , width * height * 3 
     static bool saveFrameBuffer(const std::string& filename,
-        int width, int height);
+        int width, int height, const std::vector<uint8_t>& pixels);
 
+    //     ,  (<= 0) - . palette -
+    // 8- BMP     24-
     static bool saveDepthMapAsBMP(const std::vector<std::vector<double>>& depthData,
-        const std::string& filename);
+        const DepthNormalization& normalization, const std::string& filename, bool palette = false);
+
+    // RGB-   (  glReadPixels) ->  
+    static std::vector<uint8_t> flipRows(const std::vector<uint8_t>& pixels, int width, int height);
+
+    //   : "out/frame.bmp" -> "out/frame"
+    static std::string outputStem(const std::string& imageOutput);
+    //  : <outputStem>_0001.bmp, ...
+    static std::string framePath(const std::string& imageOutput, int frame);
 
 private:
 #pragma pack(push, 1)
@@ -33,7 +46,4 @@ private:
         uint32_t colorsImportant = 0;
     };
 #pragma pack(pop)
-
-    static void normalizeDepthData(const std::vector<std::vector<double>>& depthData,
-        std::vector<uint8_t>& pixels);
 }; 
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "config_reader.h"
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+struct BRDFTables;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Параметры материала и источника, связанные один раз на рендер.
+// Производные величины считаются в bind(), а не в каждом пикселе.
+struct Material {
+    int model = 1;              // LightingModel::Model
+    Vector3 color;
+    float intensity = 1.0f;
+    float shininess = 32.0f;
+    float roughness = 0.3f;
+    float reflectance = 0.5f;
+    float ambient = 0.0f;       // фоновый свет, ослабляется фоновым затенением
+
+    float halfIntensity = 0.5f; // множитель блика Блинна
+    float zeroPow = 0.0f;       // pow(0, shininess)
+    float alpha2 = 0.0081f;     // roughness^4
+    float invAlpha2 = 0.0f;
+    float piAlpha2 = 0.0f;
+    float F0 = 0.5f;
+    float oneMinusF0 = 0.5f;
+
+    // Таблицы D, G, F и блика (brdf_lut.h); если заданы, пакетные ядра
+    // берут значения из них вместо exp/pow. Владеет ими вызывающий код.
+    const BRDFTables* tables = nullptr;
+
+    static Material bind(int model, const Vector3& color, float intensity,
+        float shininess, float roughness = 0.3f, float reflectance = 0.5f) {
+        Material m;
+        m.model = model;
+        m.color = color;
+        m.intensity = intensity;
+        m.shininess = shininess;
+        m.roughness = roughness;
+        m.reflectance = reflectance;
+
+        m.halfIntensity = intensity * 0.5f;
+        m.zeroPow = shininess == 0.0f ? 1.0f : 0.0f;
+        const float alpha = roughness * roughness;
+        m.alpha2 = std::max(alpha * alpha, 1e-7f);
+        m.invAlpha2 = 1.0f / m.alpha2;
+        m.piAlpha2 = static_cast<float>(M_PI) * m.alpha2;
+        m.F0 = reflectance;
+        m.oneMinusF0 = 1.0f - reflectance;
+        return m;
+    }
+
+    static Material fromConfig(const Config& config) {
+        Material m = bind(config.reflection_model, config.material_color, config.light_intensity,
+            config.material_shininess, config.material_roughness, config.material_reflectance);
+        m.ambient = config.ambient_intensity;
+        return m;
+    }
+};
+
+// Модели отражения как типы: ядро инстанцируется под конкретную модель,
+// и в цикле по пикселям нет ветвлений на выбор модели.
+namespace brdf {
+
+struct Unlit {
+    static constexpr bool kHalfVector = false;
+    static constexpr bool kSpecular = false;
+};
+
+struct Lambert {
+    static constexpr bool kHalfVector = false;
+    static constexpr bool kSpecular = false;
+};
+
+struct BlinnPhong {
+    static constexpr bool kHalfVector = true;
+    static constexpr bool kSpecular = true;
+};
+
+struct TorranceSparrow {
+    static constexpr bool kHalfVector = true;
+    static constexpr bool kSpecular = true;
+};
+
+// Вызывает fn(Model{}) для номера модели: одно ветвление на рендер.
+// Неизвестный номер - цвет поверхности без освещения.
+template<class Fn>
+inline decltype(auto) dispatch(int model, Fn&& fn) {
+    switch (model) {
+    case 0: return fn(Lambert{});
+    case 1: return fn(BlinnPhong{});
+    case 2: return fn(TorranceSparrow{});
+    default: return fn(Unlit{}); // неизвестный номер модели - без освещения
+    }
+}
+
+// Диффузный и зеркальный множители по косинусам углов:
+// color = material.color * diffuse + specular
+template<class Model>
+inline void evaluate(const Material& m, float NdotL, float NdotH, float NdotV, float VdotH,
+    float& diffuse, float& specular) {
+    if constexpr (std::is_same_v<Model, Unlit>) {
+        diffuse = m.intensity;
+        specular = 0.0f;
+    }
+    else if constexpr (std::is_same_v<Model, Lambert>) {
+        diffuse = NdotL * m.intensity;
+        specular = 0.0f;
+    }
+    else if constexpr (std::is_same_v<Model, BlinnPhong>) {
+        diffuse = NdotL * m.intensity;
+        specular = (NdotH > 0.0f ? powf(NdotH, m.shininess) : m.zeroPow) * m.halfIntensity;
+    }
+    else {
+        if (NdotV <= 0.001f || NdotL <= 0.001f) {
+            diffuse = NdotL * m.intensity;
+            specular = 0.0f;
+            return;
+        }
+
+        // Распределение микрограней (Бекман)
+        const float cos2 = NdotH * NdotH;
+        const float tan2 = (1.0f - cos2) / std::max(cos2, 1e-10f);
+        const float D = expf(-tan2 * m.invAlpha2) / (m.piAlpha2 * cos2 * cos2);
+
+        // Геометрическое ослабление
+        const float tanV2 = (1.0f - NdotV * NdotV) / (NdotV * NdotV);
+        const float tanL2 = (1.0f - NdotL * NdotL) / (NdotL * NdotL);
+        const float G = 2.0f / (1.0f + sqrtf(1.0f + m.alpha2 * tanV2))
+            * 2.0f / (1.0f + sqrtf(1.0f + m.alpha2 * tanL2));
+
+        // Френель (Шлик)
+        const float c = 1.0f - VdotH;
+        const float c2 = c * c;
+        const float F = m.F0 + m.oneMinusF0 * (c2 * c2 * c);
+
+        diffuse = NdotL * m.intensity * (1.0f - F);
+        specular = D * G * F / (4.0f * NdotV * NdotL) * m.intensity;
+    }
+}
+
+inline float dot(const Vector3& a, const Vector3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vector3 normalize(const Vector3& v) {
+    const float len = sqrtf(dot(v, v));
+    if (len < 1e-10f) return Vector3(0.0f, 1.0f, 0.0f);
+    return v * (1.0f / len);
+}
+
+// Цвет точки; N, L, V нормированы, occlusion - доступность фонового света
+template<class Model>
+inline Vector3 shade(const Material& m, const Vector3& N, const Vector3& L, const Vector3& V,
+    float occlusion = 1.0f) {
+    const float NdotL = std::max(0.0f, dot(N, L));
+    float NdotH = 0.0f, NdotV = 0.0f, VdotH = 0.0f;
+    if constexpr (Model::kHalfVector) {
+        const Vector3 H = normalize(L + V);
+        NdotH = std::max(0.0f, dot(N, H));
+        NdotV = std::max(0.0f, dot(N, V));
+        VdotH = std::max(0.0f, dot(V, H));
+    }
+
+    float diffuse, specular;
+    evaluate<Model>(m, NdotL, NdotH, NdotV, VdotH, diffuse, specular);
+    diffuse += m.ambient * occlusion;
+    return Vector3(m.color.x * diffuse + specular,
+        m.color.y * diffuse + specular,
+        m.color.z * diffuse + specular);
+}
+
+}
@@ -0,0 +1,64 @@
+#include "brdf_lut.h"
+#include "brdf.h"
+#include <cmath>
+#include <algorithm>
+
+// Значение в точке x по узлам k / kSize с линейной интерполяцией
+static float interpolate(const std::vector<float>& table, double x) {
+    const double scaled = x * BRDFTables::kSize;
+    const int index = std::min(static_cast<int>(scaled), BRDFTables::kSize - 1);
+    const float t = static_cast<float>(scaled - index);
+    return table[index] + t * (table[index + 1] - table[index]);
+}
+
+// Заполняет узлы и возвращает максимальную ошибку интерполяции
+// в трех внутренних точках каждого интервала, отнесенную к максимуму
+template<class Fn>
+static float fillTable(std::vector<float>& table, Fn fn) {
+    table.resize(BRDFTables::kSize + 1);
+    double peak = 0.0;
+    for (int k = 0; k <= BRDFTables::kSize; ++k) {
+        const double value = fn(static_cast<double>(k) / BRDFTables::kSize);
+        table[k] = static_cast<float>(value);
+        peak = std::max(peak, std::fabs(value));
+    }
+
+    double error = 0.0;
+    for (int k = 0; k < BRDFTables::kSize; ++k) {
+        for (int q = 1; q <= 3; ++q) {
+            const double x = (k + q * 0.25) / BRDFTables::kSize;
+            error = std::max(error, std::fabs(interpolate(table, x) - fn(x)));
+        }
+    }
+    return peak > 0.0 ? static_cast<float>(error / peak) : 0.0f;
+}
+
+BRDFTables BRDFTables::build(const Material& m) {
+    BRDFTables tables;
+    const double alpha2 = m.alpha2;
+
+    // Бекман по u = sqrt(1 - N.H): у пика узлы идут чаще, чем по N.H
+    tables.errorD = fillTable(tables.D, [&](double u) {
+        const double c = 1.0 - u * u;
+        const double cos2 = c * c;
+        if (cos2 < 1e-10) return 0.0;
+        const double tan2 = (1.0 - cos2) / cos2;
+        return std::exp(-tan2 / alpha2) / (M_PI * alpha2 * cos2 * cos2);
+    });
+
+    // G1(x) / (2x) = 1 / (x + sqrt(x^2 + alpha2 (1 - x^2))), конечна при x = 0
+    tables.errorVis = fillTable(tables.vis, [&](double x) {
+        return 1.0 / (x + std::sqrt(x * x + alpha2 * (1.0 - x * x)));
+    });
+
+    tables.errorF = fillTable(tables.F, [&](double x) {
+        const double c = 1.0 - x;
+        return m.F0 + m.oneMinusF0 * (c * c * c * c * c);
+    });
+
+    tables.errorBlinn = fillTable(tables.blinn, [&](double u) {
+        const double c = 1.0 - u * u;
+        return c > 0.0 ? std::pow(c, static_cast<double>(m.shininess)) : m.zeroPow;
+    });
+    return tables;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+struct Material;
+
+// Таблицы членов BRDF для фиксированного материала. Узлы равномерны на [0, 1],
+// между узлами - линейная интерполяция.
+//   D     - распределение Бекмана с множителем 1/(pi alpha2 cos^4),
+//           аргумент sqrt(1 - N.H) (сгущение узлов у пика);
+//   vis   - G1(x) / (2x): геометрический член Смита вместе с 1/(4 N.V N.L),
+//           G разделим, поэтому вместо таблицы G(N.V, N.L) - одна 1D;
+//   F     - Шлик по V.H;
+//   blinn - (N.H)^shininess, аргумент sqrt(1 - N.H).
+// Погрешность при kSize = 2048 относительно максимума таблицы: F - 4e-7,
+// blinn - 2e-6 при shininess 32 и 3e-5 при 512; D и vis - 1.5e-5 и 4e-6
+// при roughness 0.3, 1.2e-3 и 3e-4 при 0.1, при меньшей растет как
+// 1/roughness^4. Фактическая погрешность считается при построении.
+struct BRDFTables {
+    static const int kSize = 2048;  // интервалов; узлов kSize + 1
+
+    std::vector<float> D;
+    std::vector<float> vis;
+    std::vector<float> F;
+    std::vector<float> blinn;
+
+    // Максимальная ошибка интерполяции, отнесенная к максимуму таблицы
+    float errorD = 0.0f;
+    float errorVis = 0.0f;
+    float errorF = 0.0f;
+    float errorBlinn = 0.0f;
+
+    static BRDFTables build(const Material& material);
+};
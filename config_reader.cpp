@@ -12,6 +12,12 @@ Config ConfigReader::readConfig(const std::string& filename) {
     config.depth_map_file = "DepthMap_10.dat";
     config.output_formats = { "obj", "stl", "ply" };
     config.output_dir = "output";
+    config.depth_image_formats = { "bmp" };
+    config.depth_bmp_palette = false;
+    config.depth_png_deflate = true;
+    config.depth_normalization = "linear";
+    config.depth_percentile_low = 1.0f;
+    config.depth_percentile_high = 99.0f;
     config.light_direction = Vector3(1.0f, 1.0f, 1.0f);
     config.light_intensity = 1.0f;
     config.light_color = Vector3(1.0f, 1.0f, 1.0f);
@@ -23,12 +29,38 @@ Config ConfigReader::readConfig(const std::string& filename) {
     config.reflection_model = 1; 
     config.material_shininess = 32.0f;
     config.material_color = Vector3(0.7f, 0.7f, 0.8f);
+    config.material_roughness = 0.3f;
+    config.material_reflectance = 0.5f;
     config.image_output = "output/rendered_image.bmp";
     config.image_width = 1024;
     config.image_height = 768;
+    config.render_mode = "window";
+    config.shading_simd = "auto";
+    config.shading_lut = false;
+    config.shadows = false;
+    config.ambient_intensity = 0.0f;
+    config.ambient_occlusion = false;
+    config.ao_directions = 8;
+    config.ao_radius = 16.0f;
     config.scale = 1.0f;
     config.show_axes = true;
     config.wireframe_mode = false;
+    config.viewer_position = Vector3(0.0f, 0.0f, 5.0f);
+    config.phong_shininess = 32.0f;
+    config.lod_pixel_error = 1.0f;
+    config.capture_output = "output/viewer_capture.bmp";
+    config.turntable_step = 1.0f;
+    config.show_stats = false;
+    config.profile_output = "output/viewer_profile.csv";
+    config.mesh_binary = false;
+    config.mesh_normals = true;
+    config.ply_normals = false;
+    config.mesh_double = false;
+    config.verify_exports = false;
+    config.output_backend = "stream";
+    config.output_direct_io = false;
+    config.pointcloud_stride = 1;
+    config.pointcloud_voxel = 0.0f;
 
     std::ifstream file(filename);
 
@@ -88,6 +120,43 @@ Config ConfigReader::readConfig(const std::string& filename) {
         else if (key == "output_dir") {
             config.output_dir = value;
         }
+        else if (key == "depth_image_formats") {
+            config.depth_image_formats.clear();
+            std::stringstream ss(value);
+            std::string format;
+            while (std::getline(ss, format, ',')) {
+                format.erase(0, format.find_first_not_of(" \t"));
+                format.erase(format.find_last_not_of(" \t") + 1);
+                if (!format.empty()) {
+                    config.depth_image_formats.push_back(format);
+                }
+            }
+        }
+        else if (key == "depth_bmp_palette") {
+            config.depth_bmp_palette = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "depth_png_deflate") {
+            config.depth_png_deflate = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "depth_normalization") {
+            config.depth_normalization = value;
+        }
+        else if (key == "depth_percentile_low") {
+            try {
+                config.depth_percentile_low = std::stof(value);
+            }
+            catch (...) {
+                std::cerr << "  depth_percentile_low,    " << std::endl;
+            }
+        }
+        else if (key == "depth_percentile_high") {
+            try {
+                config.depth_percentile_high = std::stof(value);
+            }
+            catch (...) {
+                std::cerr << "  depth_percentile_high,    " << std::endl;
+            }
+        }
         else if (key == "light_direction") {
             config.light_direction = parseVector(value);
             float len = sqrt(config.light_direction.x * config.light_direction.x +
@@ -146,6 +215,22 @@ Config ConfigReader::readConfig(const std::string& filename) {
                 std::cerr << "  material_shininess,    " << std::endl;
             }
         }
+        else if (key == "material_roughness") {
+            try {
+                config.material_roughness = std::stof(value);
+            }
+            catch (...) {
+                std::cerr << "  material_roughness,    " << std::endl;
+            }
+        }
+        else if (key == "material_reflectance") {
+            try {
+                config.material_reflectance = std::stof(value);
+            }
+            catch (...) {
+                std::cerr << "  material_reflectance,    " << std::endl;
+            }
+        }
         else if (key == "material_color") {
             config.material_color = parseVector(value);
         }
@@ -168,6 +253,63 @@ Config ConfigReader::readConfig(const std::string& filename) {
                 std::cerr << "  image_height,    " << std::endl;
             }
         }
+        else if (key == "render_mode") {
+            config.render_mode = value;
+        }
+        else if (key == "shading_simd") {
+            if (value == "auto" || value == "scalar" || value == "sse2" || value == "sse"
+                || value == "avx2" || value == "avx512") {
+                config.shading_simd = value;
+            }
+            else {
+                std::cerr << "  shading_simd,    " << std::endl;
+            }
+        }
+        else if (key == "shading_lut") {
+            config.shading_lut = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "shadows") {
+            config.shadows = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "ambient_intensity") {
+            try {
+                config.ambient_intensity = std::max(0.0f, std::stof(value));
+            }
+            catch (...) {
+                std::cerr << "  ambient_intensity,    " << std::endl;
+            }
+        }
+        else if (key == "ambient_occlusion") {
+            config.ambient_occlusion = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "ao_directions") {
+            try {
+                config.ao_directions = std::max(1, std::stoi(value));
+            }
+            catch (...) {
+                std::cerr << "  ao_directions,    " << std::endl;
+            }
+        }
+        else if (key == "ao_radius") {
+            try {
+                config.ao_radius = std::max(1.0f, std::stof(value));
+            }
+            catch (...) {
+                std::cerr << "  ao_radius,    " << std::endl;
+            }
+        }
+        else if (key == "ao_output") {
+            config.ao_output.clear();
+            std::stringstream ss(value);
+            std::string path;
+            while (std::getline(ss, path, ',')) {
+                path.erase(0, path.find_first_not_of(" \t"));
+                path.erase(path.find_last_not_of(" \t") + 1);
+                if (!path.empty()) {
+                    config.ao_output.push_back(path);
+                }
+            }
+        }
         else if (key == "scale") {
             try {
                 config.scale = std::stof(value);
@@ -182,6 +324,114 @@ Config ConfigReader::readConfig(const std::string& filename) {
         else if (key == "wireframe_mode") {
             config.wireframe_mode = (value == "true" || value == "1" || value == "yes");
         }
+        else if (key == "viewer_position") {
+            config.viewer_position = parseVector(value);
+        }
+        else if (key == "phong_shininess") {
+            try {
+                config.phong_shininess = std::min(std::max(std::stof(value), 0.0f), 128.0f);
+            }
+            catch (...) {
+                std::cerr << "  phong_shininess,    " << std::endl;
+            }
+        }
+        else if (key == "lod_pixel_error") {
+            try {
+                config.lod_pixel_error = std::max(std::stof(value), 0.0f);
+            }
+            catch (...) {
+                std::cerr << "  lod_pixel_error,    " << std::endl;
+            }
+        }
+        else if (key == "capture_output") {
+            config.capture_output = value;
+        }
+        else if (key == "turntable_step") {
+            try {
+                config.turntable_step = std::stof(value);
+            }
+            catch (...) {
+                std::cerr << "  turntable_step,    " << std::endl;
+            }
+        }
+        else if (key == "show_stats") {
+            config.show_stats = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "profile_output") {
+            config.profile_output = value;
+        }
+        else if (key == "mesh_binary") {
+            config.mesh_binary = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "mesh_normals") {
+            config.mesh_normals = (value == "true" || value == "1" || value == "yes");
+            config.ply_normals = config.mesh_normals;
+        }
+        else if (key == "mesh_double") {
+            config.mesh_double = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "verify_exports") {
+            config.verify_exports = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "output_backend") {
+            config.output_backend = value;
+        }
+        else if (key == "output_direct_io") {
+            config.output_direct_io = (value == "true" || value == "1" || value == "yes");
+        }
+        else if (key == "pointcloud_stride") {
+            try {
+                config.pointcloud_stride = std::max(1, std::stoi(value));
+            }
+            catch (...) {
+                std::cerr << "  pointcloud_stride,    " << std::endl;
+            }
+        }
+        else if (key == "pointcloud_voxel") {
+            try {
+                config.pointcloud_voxel = std::max(0.0f, std::stof(value));
+            }
+            catch (...) {
+                std::cerr << "  pointcloud_voxel,    " << std::endl;
+            }
+        }
+        else if (key == "sweep_lights") {
+            config.sweep_lights.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ';')) {
+                item.erase(0, item.find_first_not_of(" \t"));
+                item.erase(item.find_last_not_of(" \t") + 1);
+                if (item.empty()) continue;
+                if (item.compare(0, 2, "az") == 0) {
+                    for (const Vector3& light : parseLightRange(item)) {
+                        config.sweep_lights.push_back(light);
+                    }
+                    continue;
+                }
+                Vector3 light = parseVector(item);
+                float len = sqrt(light.x * light.x + light.y * light.y + light.z * light.z);
+                if (len > 0.0001f) {
+                    light = light * (1.0f / len);
+                }
+                config.sweep_lights.push_back(light);
+            }
+        }
+        else if (key == "sweep_models") {
+            config.sweep_models.clear();
+            for (float model : parseList(value)) {
+                config.sweep_models.push_back(static_cast<int>(model));
+            }
+        }
+        else if (key == "sweep_shininess") {
+            config.sweep_shininess = parseList(value);
+        }
+        else if (key == "sweep_roughness") {
+            config.sweep_roughness = parseList(value);
+        }
+        else if (key == "sweep_orbit") {
+            config.sweep_orbit = parseAngles(value);
+        }
     }
 
     file.close();
@@ -238,6 +488,78 @@ Vector3 ConfigReader::parseVector(const std::string& str) {
     return Vector3(1.0f, 1.0f, 1.0f);
 }
 
+//  "a, b, c"   "from..to/count" (count  
+//  from  to )
+std::vector<float> ConfigReader::parseList(const std::string& str) {
+    std::vector<float> result;
+    const size_t range = str.find("..");
+    try {
+        if (range != std::string::npos) {
+            const size_t slash = str.find('/', range);
+            const float from = std::stof(str.substr(0, range));
+            const float to = std::stof(str.substr(range + 2, slash == std::string::npos ? std::string::npos : slash - range - 2));
+            const int count = slash == std::string::npos ? 2 : std::max(1, std::stoi(str.substr(slash + 1)));
+            for (int i = 0; i < count; ++i) {
+                result.push_back(count == 1 ? from : from + (to - from) * i / (count - 1));
+            }
+            return result;
+        }
+
+        std::stringstream ss(str);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item.erase(0, item.find_first_not_of(" \t"));
+            item.erase(item.find_last_not_of(" \t") + 1);
+            if (!item.empty()) {
+                result.push_back(std::stof(item));
+            }
+        }
+    }
+    catch (...) {
+        std::cerr << "   \"" << str << "\",  " << std::endl;
+        result.clear();
+    }
+    return result;
+}
+
+std::vector<float> ConfigReader::parseAngles(const std::string& str) {
+    std::vector<float> result = parseList(str);
+    //     (0..360/8) -  :  
+    //    ,  -  /  
+    if (str.find("..") != std::string::npos && result.size() > 1) {
+        const float span = result.back() - result.front();
+        const float turns = std::round(span / 360.0f);
+        if (turns != 0.0f && std::fabs(span - turns * 360.0f) < 1e-3f) {
+            const float from = result.front();
+            const int count = static_cast<int>(result.size());
+            for (int i = 0; i < count; ++i) {
+                result[i] = from + span * i / count;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<Vector3> ConfigReader::parseLightRange(const std::string& str) {
+    std::vector<Vector3> result;
+    const size_t elevationPos = str.find("el");
+    if (elevationPos == std::string::npos) {
+        std::cerr << "  \"" << str << "\":  az  el,  " << std::endl;
+        return result;
+    }
+    const std::vector<float> azimuths = parseAngles(str.substr(2, elevationPos - 2));
+    const std::vector<float> elevations = parseList(str.substr(elevationPos + 2));
+    const float toRadians = 3.14159265f / 180.0f;
+    for (float elevation : elevations) {
+        for (float azimuth : azimuths) {
+            const float e = elevation * toRadians;
+            const float a = azimuth * toRadians;
+            result.push_back(Vector3(cosf(e) * cosf(a), cosf(e) * sinf(a), sinf(e)));
+        }
+    }
+    return result;
+}
+
 void ConfigReader::printConfig(const Config& config) {
     std::cout << "\n===   ===\n";
     std::cout << "  : " << config.depth_map_file << "\n";
@@ -255,6 +577,21 @@ void ConfigReader::printConfig(const Config& config) {
     std::cout << "\n";
 
     std::cout << "  : " << config.output_dir << "\n";
+    std::cout << "  : ";
+    if (config.depth_image_formats.empty()) {
+        std::cout << "";
+    }
+    for (size_t i = 0; i < config.depth_image_formats.size(); ++i) {
+        std::cout << config.depth_image_formats[i];
+        if (i < config.depth_image_formats.size() - 1) std::cout << ", ";
+    }
+    std::cout << " (BMP " << (config.depth_bmp_palette ? "8   " : "24 ")
+        << ", PNG " << (config.depth_png_deflate ? "deflate" : " ") << ")\n";
+    std::cout << "  : " << config.depth_normalization;
+    if (config.depth_normalization == "percentile") {
+        std::cout << " (" << config.depth_percentile_low << "% - " << config.depth_percentile_high << "%)";
+    }
+    std::cout << "\n";
     std::cout << " : (" << config.light_direction.x << ", "
         << config.light_direction.y << ", " << config.light_direction.z << ")\n";
     std::cout << " : " << config.light_intensity << "\n";
@@ -278,12 +615,39 @@ void ConfigReader::printConfig(const Config& config) {
     }
 
     std::cout << " : " << config.material_shininess << "\n";
+    std::cout << ": " << config.material_roughness
+        << ", F0: " << config.material_reflectance << "\n";
     std::cout << " : (" << config.material_color.x << ", "
         << config.material_color.y << ", " << config.material_color.z << ")\n";
     std::cout << " : " << config.image_output << "\n";
     std::cout << " : " << config.image_width << "x" << config.image_height << "\n";
+    std::cout << " : " << config.render_mode
+        << " (SIMD : " << config.shading_simd
+        << (config.shading_lut ? ",  BRDF" : "") << ")\n";
+    std::cout << ": " << (config.shadows ? "" : "") << "\n";
+    std::cout << " : " << config.ambient_intensity;
+    if (config.ambient_occlusion) {
+        std::cout << ", AO: " << config.ao_directions << " ,  " << config.ao_radius;
+    }
+    std::cout << "\n";
     std::cout << ": " << config.scale << "\n";
     std::cout << " : " << (config.show_axes ? "" : "") << "\n";
     std::cout << " : " << (config.wireframe_mode ? "" : "") << "\n";
+    std::cout << ": " << (config.mesh_binary ? "binary" : "ASCII")
+        << ", : OBJ " << (config.mesh_normals ? "" : "")
+        << ", PLY " << (config.ply_normals ? "" : "")
+        << ", : " << (config.mesh_double ? "double" : "float")
+        << (config.verify_exports ? ",   " : "") << "\n";
+    std::cout << " : " << config.output_backend
+        << (config.output_direct_io ? " (direct I/O)" : "") << "\n";
+    std::cout << " :  " << config.pointcloud_stride
+        << ",  " << config.pointcloud_voxel << "\n";
+    if (config.render_mode == "sweep") {
+        std::cout << ":  " << config.sweep_lights.size()
+            << ",  " << config.sweep_models.size()
+            << ",  " << config.sweep_shininess.size()
+            << ",  " << config.sweep_roughness.size()
+            << ",  " << config.sweep_orbit.size() << "\n";
+    }
     std::cout << "================================\n\n";
 }
\ No newline at end of file
@@ -30,6 +30,12 @@ struct Config {
     //  
     std::vector<std::string> output_formats;
     std::string output_dir;
+    std::vector<std::string> depth_image_formats; //   : bmp, pgm, pfm, png
+    bool depth_bmp_palette;   // depth_map.bmp - 8      24 
+    bool depth_png_deflate;   // depth_map.png -  deflate (false -  )
+    std::string depth_normalization; // "linear", "percentile", "equalize"
+    float depth_percentile_low;      //   percentile, %
+    float depth_percentile_high;
 
     //  
     Vector3 light_direction;
@@ -47,15 +53,56 @@ struct Config {
     int reflection_model; // 0=, 1=-, 2=-
     float material_shininess;
     Vector3 material_color;
+    float material_roughness;   //   -
+    float material_reflectance; // F0  -
 
   
     std::string image_output;
     int image_width;
     int image_height;
+    std::string render_mode;  // "window" (OpenGL), "software" (CPU,  ), "relight", "sweep", "raycast"
+    std::string shading_simd; // "auto", "scalar", "sse2", "avx2", "avx512"
+    bool shading_lut;         // D, G, F      
+    bool shadows;             //       
+    float ambient_intensity;  //   (0 - )
+    bool ambient_occlusion;   //      
+    int ao_directions;        //   AO (/)
+    float ao_radius;          //   ,  
+    std::vector<std::string> ao_output; //   AO: .bmp  .ply ( )
 
     float scale;
     bool show_axes;
     bool wireframe_mode;
+    Vector3 viewer_position;  //    OpenGL-
+    float phong_shininess;    //  -  OpenGL-
+    float lod_pixel_error;    //     , 
+    std::string capture_output; //  : <>_0001.bmp, ...
+    float turntable_step;     //        , 
+    bool show_stats;          //     
+    std::string profile_output; // CSV      ,  -  
+
+    //   
+    bool mesh_binary;         // binary PLY/STL  ASCII
+    bool mesh_normals;        //    OBJ/PLY
+    bool ply_normals;         //   PLY:   mesh_normals  
+    bool mesh_double;         //   double  float
+    bool verify_exports;      //  OBJ/PLY/STL  
+
+    //  
+    std::string output_backend; // "stream"  "async"
+    bool output_direct_io;      // O_DIRECT / FILE_FLAG_NO_BUFFERING  async
+
+    //   
+    int pointcloud_stride;    //     (1 =  )
+    float pointcloud_voxel;   //   (0 =  )
+
+    //   (render_mode: sweep):   .
+    //   -   .
+    std::vector<Vector3> sweep_lights;    // "x,y,z; x,y,z; ..."
+    std::vector<int> sweep_models;        // "0, 1, 2"
+    std::vector<float> sweep_shininess;   // "8, 32, 128"   "8..128/5"
+    std::vector<float> sweep_roughness;
+    std::vector<float> sweep_orbit;       //    camera_up, 
 };
 
 class ConfigReader {
@@ -65,4 +112,10 @@ public:
 
 private:
     static Vector3 parseVector(const std::string& str);
+    static std::vector<float> parseList(const std::string& str);
+    //   :  parseList,       
+    static std::vector<float> parseAngles(const std::string& str);
+    // "az 0..360/8 el 30..60/2":     ( +X  +Y)
+    //     ,  
+    static std::vector<Vector3> parseLightRange(const std::string& str);
 };
@@ -0,0 +1,444 @@
+#include "depth_image_saver.h"
+#include "mapped_file.h"
+#include "output_sink.h"
+#include "parallel_utils.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+
+namespace {
+
+bool checkSize(const std::vector<std::vector<double>>& depthData, int& width, int& height) {
+    height = static_cast<int>(depthData.size());
+    width = height > 0 ? static_cast<int>(depthData[0].size()) : 0;
+    if (width == 0) {
+        std::cerr << "Ошибка: пустые данные глубины" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Заголовок + данные в файл точного размера, отображенный в память;
+// fillRows(rowBegin, rowEnd, rows) заполняет диапазон строк (rows - начало
+// строки rowBegin), диапазоны делятся между потоками
+template<class FillRows>
+bool saveMapped(const std::string& filename, const std::string& header,
+    int height, size_t rowBytes, FillRows fillRows) {
+    MappedFile file;
+    if (!file.create(filename, header.size() + rowBytes * height)) {
+        return false;
+    }
+    std::memcpy(file.data(), header.data(), header.size());
+    uint8_t* pixelBase = reinterpret_cast<uint8_t*>(file.data() + header.size());
+    parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        fillRows(rowBegin, rowEnd, pixelBase + rowBytes * rowBegin);
+    }, 16);
+
+    if (!file.close()) {
+        std::cerr << "Ошибка записи в файл " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 16 бит серого -> байты PNG/PGM (старший байт первым)
+void storeBigEndian(const uint16_t* gray, int width, uint8_t* bytes) {
+    for (int x = 0; x < width; ++x) {
+        bytes[2 * x + 0] = static_cast<uint8_t>(gray[x] >> 8);
+        bytes[2 * x + 1] = static_cast<uint8_t>(gray[x]);
+    }
+}
+
+// --- Deflate (RFC 1951) и zlib (RFC 1950) для PNG ---
+
+const int kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const int kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const int kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+const int kWindow = 32768;
+const int kHashBits = 15;
+const int kMaxMatch = 258;
+
+// Биты пишутся младшим вперед, коды Хаффмана - старшим
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void put(uint32_t bits, int count) {
+        buffer |= static_cast<uint64_t>(bits) << filled;
+        filled += count;
+        while (filled >= 8) {
+            out.push_back(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+            filled -= 8;
+        }
+    }
+
+    void flush() {
+        if (filled > 0) {
+            out.push_back(static_cast<uint8_t>(buffer));
+        }
+        buffer = 0;
+        filled = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t buffer = 0;
+    int filled = 0;
+};
+
+struct HuffmanCode {
+    uint16_t bits;   // код в порядке записи (развернутый)
+    uint8_t length;
+};
+
+uint16_t reverseBits(uint32_t code, int length) {
+    uint32_t result = 0;
+    for (int i = 0; i < length; ++i) {
+        result = (result << 1) | ((code >> i) & 1);
+    }
+    return static_cast<uint16_t>(result);
+}
+
+// Фиксированные коды литералов/длин (BTYPE = 01)
+const std::array<HuffmanCode, 288>& fixedCodes() {
+    static const std::array<HuffmanCode, 288> codes = [] {
+        std::array<HuffmanCode, 288> table{};
+        for (int symbol = 0; symbol < 288; ++symbol) {
+            uint32_t code;
+            int length;
+            if (symbol < 144) { code = 0x30 + symbol; length = 8; }
+            else if (symbol < 256) { code = 0x190 + symbol - 144; length = 9; }
+            else if (symbol < 280) { code = symbol - 256; length = 7; }
+            else { code = 0xC0 + symbol - 280; length = 8; }
+            table[symbol] = HuffmanCode{ reverseBits(code, length), static_cast<uint8_t>(length) };
+        }
+        return table;
+    }();
+    return codes;
+}
+
+int findCode(const int* base, int count, int value) {
+    int code = count - 1;
+    while (base[code] > value) --code;
+    return code;
+}
+
+uint32_t hash3(const uint8_t* data) {
+    const uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// Блок с фиксированными кодами: жадный LZ77, одна проба хеша на позицию.
+// В конце - пустой блок stored, выравнивающий поток по байту, чтобы
+// независимо сжатые части склеивались в один поток deflate.
+void deflateFast(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    const std::array<HuffmanCode, 288>& codes = fixedCodes();
+    BitWriter bits(out);
+    bits.put(0, 1); // BFINAL
+    bits.put(1, 2); // BTYPE = 01
+
+    std::vector<int32_t> head(size_t(1) << kHashBits, -1);
+    size_t pos = 0;
+    while (pos < size) {
+        size_t length = 0;
+        size_t distance = 0;
+        if (pos + 3 <= size) {
+            const uint32_t hash = hash3(data + pos);
+            const int32_t candidate = head[hash];
+            head[hash] = static_cast<int32_t>(pos);
+            if (candidate >= 0 && pos - candidate <= static_cast<size_t>(kWindow)) {
+                const size_t limit = std::min(static_cast<size_t>(kMaxMatch), size - pos);
+                size_t n = 0;
+                while (n < limit && data[candidate + n] == data[pos + n]) ++n;
+                if (n >= 3) {
+                    length = n;
+                    distance = pos - candidate;
+                }
+            }
+        }
+
+        if (length == 0) {
+            const HuffmanCode& code = codes[data[pos]];
+            bits.put(code.bits, code.length);
+            ++pos;
+            continue;
+        }
+
+        const int lengthCode = findCode(kLengthBase, 29, static_cast<int>(length));
+        const HuffmanCode& code = codes[257 + lengthCode];
+        bits.put(code.bits, code.length);
+        bits.put(static_cast<uint32_t>(length - kLengthBase[lengthCode]), kLengthExtra[lengthCode]);
+        const int distanceCode = findCode(kDistanceBase, 30, static_cast<int>(distance));
+        bits.put(reverseBits(distanceCode, 5), 5);
+        bits.put(static_cast<uint32_t>(distance - kDistanceBase[distanceCode]), kDistanceExtra[distanceCode]);
+
+        // Позиции внутри совпадения тоже попадают в хеш
+        for (size_t k = pos + 1; k < pos + length && k + 3 <= size; ++k) {
+            head[hash3(data + k)] = static_cast<int32_t>(k);
+        }
+        pos += length;
+    }
+    bits.put(codes[256].bits, codes[256].length);
+
+    bits.put(0, 3); // BFINAL = 0, BTYPE = 00
+    bits.flush();
+    const uint8_t empty[4] = { 0x00, 0x00, 0xFF, 0xFF };
+    out.insert(out.end(), empty, empty + 4);
+}
+
+// Блоки stored по 65535 байт, поток остается выровненным по байту
+void deflateStored(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    for (size_t pos = 0; pos < size;) {
+        const size_t n = std::min(static_cast<size_t>(65535), size - pos);
+        const uint8_t header[5] = { 0x00,
+            static_cast<uint8_t>(n), static_cast<uint8_t>(n >> 8),
+            static_cast<uint8_t>(~n), static_cast<uint8_t>(~n >> 8) };
+        out.insert(out.end(), header, header + 5);
+        out.insert(out.end(), data + pos, data + pos + n);
+        pos += n;
+    }
+}
+
+struct Adler32 {
+    uint32_t a = 1;
+    uint32_t b = 0;
+};
+
+const uint32_t kAdlerModulo = 65521;
+
+Adler32 adler32(const uint8_t* data, size_t size) {
+    Adler32 sum;
+    while (size > 0) {
+        // 5552 байта - максимум без переполнения 32 бит
+        const size_t n = std::min(size, static_cast<size_t>(5552));
+        for (size_t i = 0; i < n; ++i) {
+            sum.a += data[i];
+            sum.b += sum.a;
+        }
+        sum.a %= kAdlerModulo;
+        sum.b %= kAdlerModulo;
+        data += n;
+        size -= n;
+    }
+    return sum;
+}
+
+// Сумма потока, продолженного частью part длины size
+void appendAdler(Adler32& total, const Adler32& part, size_t size) {
+    const uint64_t b = total.b + part.b + (size % kAdlerModulo) * (total.a + kAdlerModulo - 1);
+    total.a = (total.a + part.a + kAdlerModulo - 1) % kAdlerModulo;
+    total.b = static_cast<uint32_t>(b % kAdlerModulo);
+}
+
+uint32_t updateCRC(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    const uint8_t bytes[4] = { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) };
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+void putChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* data, size_t size) {
+    putBigEndian(png, static_cast<uint32_t>(size));
+    const size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data, data + size);
+    putBigEndian(png, ~updateCRC(0xFFFFFFFFu, png.data() + start, size + 4));
+}
+
+// Фильтр строки PNG с наименьшей суммой модулей разностей (None, Sub, Up);
+// out - байт фильтра и отфильтрованная строка
+void filterRow(const uint8_t* row, const uint8_t* previous, size_t size, uint8_t* out) {
+    const size_t bytesPerPixel = 2;
+    long sums[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+        sums[0] += std::abs(static_cast<int8_t>(row[i]));
+        sums[1] += std::abs(static_cast<int8_t>(static_cast<uint8_t>(row[i] - left)));
+        sums[2] += std::abs(static_cast<int8_t>(static_cast<uint8_t>(row[i] - previous[i])));
+    }
+    const int filter = static_cast<int>(std::min_element(sums, sums + 3) - sums);
+    out[0] = static_cast<uint8_t>(filter);
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+        const uint8_t predictor = filter == 1 ? left : (filter == 2 ? previous[i] : 0);
+        out[1 + i] = static_cast<uint8_t>(row[i] - predictor);
+    }
+}
+
+}
+
+bool DepthImageSaver::savePGM(const std::vector<std::vector<double>>& depthData,
+    const DepthNormalization& normalization, const std::string& filename) {
+    int width = 0, height = 0;
+    if (!checkSize(depthData, width, height)) {
+        return false;
+    }
+
+    const std::string header = "P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n65535\n";
+    const bool ok = saveMapped(filename, header, height, static_cast<size_t>(width) * 2,
+        [&](int rowBegin, int rowEnd, uint8_t* rows) {
+            std::vector<uint16_t> gray(width);
+            for (int y = rowBegin; y < rowEnd; ++y) {
+                normalization.toGray16(depthData[y].data(), width, gray.data());
+                storeBigEndian(gray.data(), width, rows + static_cast<size_t>(width) * 2 * (y - rowBegin));
+            }
+        });
+    if (ok) {
+        std::cout << "Карта глубины сохранена как PGM (16 бит): " << filename << std::endl;
+    }
+    return ok;
+}
+
+bool DepthImageSaver::savePFM(const std::vector<std::vector<double>>& depthData,
+    const std::string& filename) {
+    int width = 0, height = 0;
+    if (!checkSize(depthData, width, height)) {
+        return false;
+    }
+
+    // Отрицательный масштаб - little-endian; строки снизу вверх
+    const std::string header = "Pf\n" + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n";
+    const bool ok = saveMapped(filename, header, height, static_cast<size_t>(width) * sizeof(float),
+        [&](int rowBegin, int rowEnd, uint8_t* rows) {
+            // Заголовок произвольной длины: строка собирается отдельно и копируется
+            std::vector<float> values(width);
+            for (int y = rowBegin; y < rowEnd; ++y) {
+                const std::vector<double>& depth = depthData[height - 1 - y];
+                for (int x = 0; x < width; ++x) {
+                    values[x] = depth[x] > 0.0 ? static_cast<float>(depth[x]) : 0.0f;
+                }
+                std::memcpy(rows + values.size() * sizeof(float) * (y - rowBegin),
+                    values.data(), values.size() * sizeof(float));
+            }
+        });
+    if (ok) {
+        std::cout << "Карта глубины сохранена как PFM: " << filename << std::endl;
+    }
+    return ok;
+}
+
+bool DepthImageSaver::savePNG(const std::vector<std::vector<double>>& depthData,
+    const DepthNormalization& normalization, const std::string& filename, bool compress) {
+    int width = 0, height = 0;
+    if (!checkSize(depthData, width, height)) {
+        return false;
+    }
+
+    // Строки делятся на части по ~256 КБ, каждая фильтруется и сжимается
+    // независимо; результат не зависит от числа потоков
+    const size_t rowBytes = static_cast<size_t>(width) * 2;
+    const int rowsPerPart = std::max(1, static_cast<int>((size_t(256) << 10) / (rowBytes + 1)));
+    const int partCount = (height + rowsPerPart - 1) / rowsPerPart;
+    std::vector<std::vector<uint8_t>> parts(partCount);
+    std::vector<Adler32> sums(partCount);
+    std::vector<size_t> sizes(partCount);
+
+    parallelFor(0, partCount, [&](int partBegin, int partEnd) {
+        std::vector<uint16_t> gray(width);
+        std::vector<uint8_t> row(rowBytes);
+        std::vector<uint8_t> previous(rowBytes);
+        std::vector<uint8_t> raw;
+        for (int part = partBegin; part < partEnd; ++part) {
+            const int rowBegin = part * rowsPerPart;
+            const int rowEnd = std::min(height, rowBegin + rowsPerPart);
+            raw.resize((rowBytes + 1) * (rowEnd - rowBegin));
+
+            // Фильтру Up нужна предыдущая строка, в том числе из соседней части
+            std::fill(previous.begin(), previous.end(), uint8_t(0));
+            if (compress && rowBegin > 0) {
+                normalization.toGray16(depthData[rowBegin - 1].data(), width, gray.data());
+                storeBigEndian(gray.data(), width, previous.data());
+            }
+            for (int y = rowBegin; y < rowEnd; ++y) {
+                normalization.toGray16(depthData[y].data(), width, gray.data());
+                uint8_t* out = raw.data() + (rowBytes + 1) * (y - rowBegin);
+                if (compress) {
+                    storeBigEndian(gray.data(), width, row.data());
+                    filterRow(row.data(), previous.data(), rowBytes, out);
+                    std::swap(row, previous);
+                }
+                else {
+                    out[0] = 0;
+                    storeBigEndian(gray.data(), width, out + 1);
+                }
+            }
+
+            sums[part] = adler32(raw.data(), raw.size());
+            sizes[part] = raw.size();
+            if (compress) {
+                deflateFast(raw.data(), raw.size(), parts[part]);
+            }
+            else {
+                deflateStored(raw.data(), raw.size(), parts[part]);
+            }
+        }
+    });
+
+    // Поток zlib: заголовок, части, пустой последний блок, Adler-32
+    std::vector<uint8_t> stream = { 0x78, 0x01 };
+    Adler32 adler;
+    size_t streamSize = stream.size() + 2 + 4;
+    for (int part = 0; part < partCount; ++part) {
+        streamSize += parts[part].size();
+    }
+    stream.reserve(streamSize);
+    for (int part = 0; part < partCount; ++part) {
+        stream.insert(stream.end(), parts[part].begin(), parts[part].end());
+        std::vector<uint8_t>().swap(parts[part]);
+        appendAdler(adler, sums[part], sizes[part]);
+    }
+    stream.push_back(0x03); // BFINAL = 1, BTYPE = 01, конец блока
+    stream.push_back(0x00);
+    putBigEndian(stream, (adler.b << 16) | adler.a);
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.reserve(stream.size() + 64);
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header, static_cast<uint32_t>(height));
+    const uint8_t format[5] = { 16, 0, 0, 0, 0 }; // 16 бит, серый, deflate, фильтры, без чередования
+    header.insert(header.end(), format, format + 5);
+    putChunk(png, "IHDR", header.data(), header.size());
+    putChunk(png, "IDAT", stream.data(), stream.size());
+    putChunk(png, "IEND", nullptr, 0);
+
+    auto sink = OutputSink::open(filename);
+    if (!sink) {
+        return false;
+    }
+    const bool ok = sink->write(reinterpret_cast<const char*>(png.data()), png.size()) && sink->close();
+    if (!ok) {
+        std::cerr << "Ошибка записи в файл " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Карта глубины сохранена как PNG (16 бит" << (compress ? ", deflate" : "")
+        << "): " << filename << " (" << png.size() / 1024 << " КБ)" << std::endl;
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "depth_normalization.h"
+#include <string>
+#include <vector>
+
+// Карта глубины в форматах точнее 8-битного BMP: PGM (P5, 16 бит), PFM
+// (float) и PNG (16 бит серого). Строки заполняются и сжимаются в
+// несколько потоков, файл пишется целиком за один раз.
+class DepthImageSaver {
+public:
+    // Яркость 0-65535 из normalization, фон - 0
+    static bool savePGM(const std::vector<std::vector<double>>& depthData,
+        const DepthNormalization& normalization, const std::string& filename);
+
+    // Глубина без нормализации (float, фон - 0): точность для других программ
+    static bool savePFM(const std::vector<std::vector<double>>& depthData,
+        const std::string& filename);
+
+    // compress: false - deflate без сжатия (только блоки stored), true -
+    // фильтры строк PNG и быстрый deflate (LZ77 с одной пробой хеша,
+    // фиксированные коды Хаффмана)
+    static bool savePNG(const std::vector<std::vector<double>>& depthData,
+        const DepthNormalization& normalization, const std::string& filename, bool compress);
+};
@@ -0,0 +1,157 @@
+#include "depth_normalization.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+int binIndex(double depth, double minDepth, double binScale, int bins) {
+    const double bin = (depth - minDepth) * binScale;
+    return static_cast<int>(std::min(std::max(bin, 0.0), static_cast<double>(bins - 1)));
+}
+
+}
+
+DepthNormalization::Mode DepthNormalization::modeFromName(const std::string& name) {
+    if (name == "percentile") return PERCENTILE;
+    if (name == "equalize" || name == "histogram") return EQUALIZE;
+    return LINEAR;
+}
+
+const char* DepthNormalization::modeName(Mode mode) {
+    switch (mode) {
+    case PERCENTILE: return "percentile";
+    case EQUALIZE: return "equalize";
+    default: return "linear";
+    }
+}
+
+bool DepthNormalization::compute(const std::vector<std::vector<double>>& depthData,
+    Mode mode, double lowPercent, double highPercent) {
+    const int height = static_cast<int>(depthData.size());
+    minDepth = std::numeric_limits<double>::max();
+    maxDepth = 0.0;
+    equalization.clear();
+
+    // Каждый поток считает свой диапазон строк, итоги сливаются один раз
+    std::mutex mutex;
+    parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        double localMin = std::numeric_limits<double>::max();
+        double localMax = 0.0;
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            for (double depth : depthData[y]) {
+                // Фон (0 или отрицательные значения) не влияет на минимум
+                localMin = std::min(localMin, depth > 0.0 ? depth : std::numeric_limits<double>::max());
+                localMax = std::max(localMax, depth);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        minDepth = std::min(minDepth, localMin);
+        maxDepth = std::max(maxDepth, localMax);
+    }, 64);
+
+    if (!(maxDepth > 0.0)) {
+        minDepth = maxDepth = lowDepth = highDepth = 0.0;
+        return false;
+    }
+    lowDepth = minDepth;
+    highDepth = maxDepth;
+    binScale = maxDepth > minDepth ? HISTOGRAM_BINS / (maxDepth - minDepth) : 0.0;
+    if (mode == LINEAR || binScale == 0.0) {
+        return true;
+    }
+
+    const std::vector<uint32_t> counts = histogram(depthData);
+    uint64_t total = 0;
+    for (uint32_t count : counts) {
+        total += count;
+    }
+
+    if (mode == PERCENTILE) {
+        lowPercent = std::min(std::max(lowPercent, 0.0), 100.0);
+        highPercent = std::min(std::max(highPercent, lowPercent), 100.0);
+        const double lowCount = total * lowPercent / 100.0;
+        const double highCount = total * highPercent / 100.0;
+        int lowBin = -1;
+        int highBin = HISTOGRAM_BINS - 1;
+        uint64_t cumulative = 0;
+        for (int bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+            cumulative += counts[bin];
+            if (lowBin < 0 && cumulative > lowCount) lowBin = bin;
+            if (cumulative >= highCount && counts[bin] > 0) {
+                highBin = bin;
+                break;
+            }
+        }
+        // Точность границ - ширина корзины
+        lowDepth = std::max(minDepth, minDepth + std::max(lowBin, 0) / binScale);
+        highDepth = std::min(maxDepth, minDepth + (highBin + 1) / binScale);
+        if (!(highDepth > lowDepth)) {
+            lowDepth = minDepth;
+            highDepth = maxDepth;
+        }
+        return true;
+    }
+
+    // Яркость корзины - доля отсчетов с глубиной не больше ее верхней границы
+    equalization.resize(HISTOGRAM_BINS);
+    uint64_t cumulative = 0;
+    for (int bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+        cumulative += counts[bin];
+        equalization[bin] = static_cast<uint16_t>(cumulative * 65535 / total);
+    }
+    return true;
+}
+
+std::vector<uint32_t> DepthNormalization::histogram(const std::vector<std::vector<double>>& depthData) const {
+    std::vector<uint32_t> counts(HISTOGRAM_BINS, 0);
+    std::mutex mutex;
+    parallelFor(0, static_cast<int>(depthData.size()), [&](int rowBegin, int rowEnd) {
+        // Своя гистограмма у потока: без атомарных операций и общих строк кэша
+        std::vector<uint32_t> local(HISTOGRAM_BINS, 0);
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            for (double depth : depthData[y]) {
+                if (depth > 0.0) {
+                    ++local[binIndex(depth, minDepth, binScale, HISTOGRAM_BINS)];
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+            counts[bin] += local[bin];
+        }
+    }, 64);
+    return counts;
+}
+
+// Без ветвлений и зависимостей между пикселями: циклы векторизуются
+template<class T>
+void DepthNormalization::convert(const double* depth, int width, double levels, T* gray) const {
+    if (!equalization.empty()) {
+        const int shift = sizeof(T) == 1 ? 8 : 0;
+        for (int x = 0; x < width; ++x) {
+            const int bin = binIndex(depth[x], minDepth, binScale, HISTOGRAM_BINS);
+            gray[x] = static_cast<T>(depth[x] > 0.0 ? equalization[bin] >> shift : 0);
+        }
+        return;
+    }
+
+    if (!(highDepth > lowDepth)) {
+        std::fill(gray, gray + width, T(0));
+        return;
+    }
+    const double range = highDepth - lowDepth;
+    for (int x = 0; x < width; ++x) {
+        const double normalized = std::min(std::max((depth[x] - lowDepth) / range, 0.0), 1.0);
+        gray[x] = static_cast<T>(depth[x] > 0.0 ? static_cast<int>(normalized * levels) : 0);
+    }
+}
+
+void DepthNormalization::toGray8(const double* depth, int width, uint8_t* gray) const {
+    convert(depth, width, 255.0, gray);
+}
+
+void DepthNormalization::toGray16(const double* depth, int width, uint16_t* gray) const {
+    convert(depth, width, 65535.0, gray);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Отображение глубины в яркость, общее для всех изображений карты глубины
+// (BMP, PGM, PNG): параметры считаются один раз, строки переводятся без
+// ветвлений. Фон (глубина <= 0) - всегда 0.
+//
+// LINEAR     - от минимума до максимума глубины;
+// PERCENTILE - от lowPercent до highPercent процентиля, значения за
+//              пределами обрезаются: редкие выбросы не сжимают остальной
+//              диапазон в несколько оттенков;
+// EQUALIZE   - выравнивание гистограммы: яркость пропорциональна доле
+//              отсчетов ближе данного, через таблицу по корзинам.
+// Для PERCENTILE и EQUALIZE - второй проход: гистограммы потоков по
+// HISTOGRAM_BINS корзинам между минимумом и максимумом, сливаемые один раз.
+class DepthNormalization {
+public:
+    enum Mode {
+        LINEAR = 0,
+        PERCENTILE = 1,
+        EQUALIZE = 2
+    };
+
+    static Mode modeFromName(const std::string& name);
+    static const char* modeName(Mode mode);
+
+    // false - в карте только фон
+    bool compute(const std::vector<std::vector<double>>& depthData,
+        Mode mode = LINEAR, double lowPercent = 1.0, double highPercent = 99.0);
+
+    // Строка глубины -> яркость 0-255 / 0-65535
+    void toGray8(const double* depth, int width, uint8_t* gray) const;
+    void toGray16(const double* depth, int width, uint16_t* gray) const;
+
+    double getMinDepth() const { return minDepth; }
+    double getMaxDepth() const { return maxDepth; }
+    // Границы линейного отображения (у PERCENTILE - после обрезки)
+    double getLowDepth() const { return lowDepth; }
+    double getHighDepth() const { return highDepth; }
+
+private:
+    static const int HISTOGRAM_BINS = 1 << 16;
+
+    std::vector<uint32_t> histogram(const std::vector<std::vector<double>>& depthData) const;
+
+    template<class T>
+    void convert(const double* depth, int width, double levels, T* gray) const;
+
+    double minDepth = 0.0;
+    double maxDepth = 0.0;
+    double lowDepth = 0.0;
+    double highDepth = 0.0;
+    double binScale = 0.0;               // корзин на единицу глубины
+    std::vector<uint16_t> equalization;  // яркость 0-65535 по корзинам (EQUALIZE)
+};
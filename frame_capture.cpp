@@ -0,0 +1,168 @@
+#include "frame_capture.h"
+#include "gl_functions.h"
+#include "bmp_saver.h"
+#include <iostream>
+#include <cstring>
+
+FrameCapture::~FrameCapture() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void FrameCapture::initialize(const std::string& path) {
+    release();
+    output = path;
+    pixelBuffers = GLFunctions::loadPixelBuffers();
+}
+
+void FrameCapture::release() {
+    for (Slot& slot : slots) {
+        if (slot.buffer != 0) {
+            GLFunctions::deleteBuffers(1, &slot.buffer);
+        }
+        slot = Slot();
+    }
+    nextSlot = 0;
+}
+
+void FrameCapture::captureFrame() {
+    requested = true;
+}
+
+void FrameCapture::setRecording(bool enabled) {
+    if (recording == enabled) return;
+    recording = enabled;
+    if (enabled) {
+        dropped = 0;
+        std::cout << "Запись кадров: " << BMPSaver::framePath(output, nextFile) << " и далее" << std::endl;
+    }
+    else {
+        std::cout << "Запись кадров остановлена";
+        if (dropped > 0) {
+            std::cout << ", пропущено " << dropped << " (запись на диск не успевала)";
+        }
+        std::cout << std::endl;
+    }
+}
+
+bool FrameCapture::endFrame(int width, int height) {
+    // Кадры, которые GPU уже успел скопировать
+    for (Slot& slot : slots) {
+        if (slot.pending && frame - slot.issued >= RING - 1) {
+            collect(slot);
+        }
+    }
+
+    if ((requested || recording) && width > 0 && height > 0) {
+        requested = false;
+        const size_t size = static_cast<size_t>(width) * height * 3;
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        if (pixelBuffers) {
+            Slot& slot = slots[nextSlot];
+            nextSlot = (nextSlot + 1) % RING;
+            if (slot.pending) {
+                collect(slot);
+            }
+            if (slot.buffer == 0) {
+                GLFunctions::genBuffers(1, &slot.buffer);
+            }
+            GLFunctions::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            if (slot.capacity != size) {
+                GLFunctions::bufferData(GL_PIXEL_PACK_BUFFER, static_cast<ptrdiff_t>(size), nullptr, GL_STREAM_READ);
+                slot.capacity = size;
+            }
+            // С привязанным PBO последний аргумент - смещение в буфере,
+            // вызов только ставит копирование в очередь GPU
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            GLFunctions::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.width = width;
+            slot.height = height;
+            slot.issued = frame;
+            slot.pending = true;
+        }
+        else {
+            std::vector<uint8_t> pixels(size);
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+            enqueue(width, height, std::move(pixels));
+        }
+    }
+    ++frame;
+
+    for (const Slot& slot : slots) {
+        if (slot.pending) return true;
+    }
+    return false;
+}
+
+void FrameCapture::finish() {
+    for (int k = 0; k < RING; ++k) {
+        Slot& slot = slots[(nextSlot + k) % RING];
+        if (slot.pending) {
+            collect(slot);
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+void FrameCapture::collect(Slot& slot) {
+    slot.pending = false;
+    GLFunctions::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* data = GLFunctions::mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (data != nullptr) {
+        std::vector<uint8_t> pixels(slot.capacity);
+        std::memcpy(pixels.data(), data, slot.capacity);
+        GLFunctions::unmapBuffer(GL_PIXEL_PACK_BUFFER);
+        enqueue(slot.width, slot.height, std::move(pixels));
+    }
+    else {
+        std::cerr << "Ошибка: не удалось прочитать буфер пикселей кадра" << std::endl;
+    }
+    GLFunctions::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::enqueue(int width, int height, std::vector<uint8_t> pixels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Окно не ждет диска: при переполненной очереди кадр пропускается
+    if (queue.size() >= MAX_QUEUED) {
+        ++dropped;
+        return;
+    }
+    queue.push_back(Job{ BMPSaver::framePath(output, nextFile++), width, height, std::move(pixels) });
+    if (!worker.joinable()) {
+        worker = std::thread(&FrameCapture::loop, this);
+    }
+    cv.notify_all();
+}
+
+void FrameCapture::loop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !queue.empty() || stopping; });
+            // Перед остановкой очередь дописывается
+            if (queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            writing = true;
+        }
+
+        // Строки GL идут снизу вверх, BMPSaver ждет сверху вниз
+        BMPSaver::saveFrameBuffer(job.path, job.width, job.height,
+            BMPSaver::flipRows(job.pixels, job.width, job.height));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+        }
+        cv.notify_all();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Захват кадров OpenGL-окна в BMP. Кадр копируется glReadPixels в одно из
+// RING буферов пикселей (PBO) без ожидания GPU и отображается в память
+// через RING - 1 кадров, когда копирование уже закончено; переворот строк
+// и запись файла - в фоновом потоке. Без PBO чтение синхронное, запись
+// все равно в фоне. Файлы: <output без .bmp>_0001.bmp, _0002.bmp, ...
+class FrameCapture {
+public:
+    ~FrameCapture();
+
+    // Нужен текущий контекст GL
+    void initialize(const std::string& output);
+    void release();
+
+    void captureFrame();                  // следующий нарисованный кадр
+    void setRecording(bool enabled);      // каждый нарисованный кадр
+    bool isRecording() const { return recording; }
+
+    // После отрисовки, до обмена буферов. true - в кольце остались
+    // непрочитанные кадры, нужно нарисовать еще
+    bool endFrame(int width, int height);
+    // Забирает кадры из кольца (с ожиданием GPU) и дожидается записи
+    void finish();
+
+private:
+    static const int RING = 3;
+    static const size_t MAX_QUEUED = 32; // кадров в очереди записи, лишние пропускаются
+
+    struct Slot {
+        unsigned int buffer = 0;
+        size_t capacity = 0;
+        int width = 0, height = 0;
+        long long issued = 0;
+        bool pending = false;
+    };
+
+    struct Job {
+        std::string path;
+        int width, height;
+        std::vector<uint8_t> pixels; // строки снизу вверх, как отдает GL
+    };
+
+    void collect(Slot& slot);
+    void enqueue(int width, int height, std::vector<uint8_t> pixels);
+    void loop();
+
+    std::string output;
+    bool pixelBuffers = false;
+    Slot slots[RING];
+    int nextSlot = 0;
+    long long frame = 0;
+    bool requested = false;
+    bool recording = false;
+    int nextFile = 1;
+    int dropped = 0;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> queue;
+    bool writing = false;
+    bool stopping = false;
+};
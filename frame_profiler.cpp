@@ -0,0 +1,193 @@
+#include "frame_profiler.h"
+#include "gl_functions.h"
+#include <GL/freeglut.h>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void FrameProfiler::initialize() {
+    release();
+    timerQueries = GLFunctions::loadTimerQueries();
+    if (timerQueries) {
+        for (Query& query : queries) {
+            GLFunctions::genQueries(1, &query.id);
+        }
+    }
+}
+
+void FrameProfiler::release() {
+    for (Query& query : queries) {
+        if (query.id != 0) {
+            GLFunctions::deleteQueries(1, &query.id);
+        }
+        query = Query();
+    }
+    timerQueries = false;
+    queryActive = false;
+    firstResult = true;
+    nextQuery = 0;
+}
+
+void FrameProfiler::beginFrame() {
+    frameStart = std::chrono::steady_clock::now();
+    poll(false);
+
+    // Запрос, чей результат еще не готов, не переиспользуется: кадр
+    // остается без времени GPU, но и без ожидания
+    queryActive = false;
+    if (timerQueries) {
+        Query& query = queries[nextQuery];
+        if (query.frame < 0) {
+            GLFunctions::beginQuery(GL_TIME_ELAPSED, query.id);
+            query.frame = static_cast<long long>(history.size());
+            queryActive = true;
+            nextQuery = (nextQuery + 1) % QUERIES;
+        }
+    }
+}
+
+void FrameProfiler::endFrame(int triangles, int chunks, int culledChunks) {
+    if (queryActive) {
+        GLFunctions::endQuery(GL_TIME_ELAPSED);
+        queryActive = false;
+    }
+    const double cpu = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - frameStart).count();
+    history.push_back(Sample{ cpu, -1.0, triangles, chunks, culledChunks });
+}
+
+void FrameProfiler::poll(bool wait) {
+    for (Query& query : queries) {
+        if (query.frame < 0) continue;
+        GLint available = 0;
+        if (!wait) {
+            GLFunctions::getQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+        }
+        uint64_t nanoseconds = 0;
+        GLFunctions::getQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+        // Первый результат отбрасывается: у части драйверов (llvmpipe)
+        // первый запрос контекста отсчитывается не от начала кадра
+        if (!firstResult && query.frame < static_cast<long long>(history.size())) {
+            history[static_cast<size_t>(query.frame)].gpu = nanoseconds / 1e6;
+        }
+        firstResult = false;
+        query.frame = -1;
+    }
+}
+
+FrameProfiler::Percentiles FrameProfiler::percentiles(double Sample::* value, size_t window) const {
+    std::vector<double> values;
+    const size_t first = history.size() > window ? history.size() - window : 0;
+    for (size_t k = first; k < history.size(); ++k) {
+        if (history[k].*value >= 0.0) {
+            values.push_back(history[k].*value);
+        }
+    }
+
+    Percentiles result;
+    result.count = static_cast<int>(values.size());
+    if (values.empty()) {
+        return result;
+    }
+    std::sort(values.begin(), values.end());
+    // Ближайший ранг: наименьшее значение, не меньше которого p всех кадров
+    auto rank = [&values](double p) {
+        const size_t index = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::min(std::max(index, size_t(1)), values.size()) - 1];
+    };
+    result.p50 = rank(0.50);
+    result.p95 = rank(0.95);
+    result.p99 = rank(0.99);
+    return result;
+}
+
+void FrameProfiler::drawOverlay(int width, int height) const {
+    const Percentiles cpu = percentiles(&Sample::cpu, WINDOW);
+    const Percentiles gpu = percentiles(&Sample::gpu, WINDOW);
+    const Sample last = history.empty() ? Sample{ 0.0, -1.0, 0, 0, 0 } : history.back();
+
+    // Шрифты GLUT - только ASCII
+    char lines[4][128];
+    snprintf(lines[0], sizeof(lines[0]), "frames %zu (last %d)  p50 / p95 / p99, ms", history.size(), cpu.count);
+    snprintf(lines[1], sizeof(lines[1]), "CPU  %.2f / %.2f / %.2f", cpu.p50, cpu.p95, cpu.p99);
+    if (timerQueries) {
+        snprintf(lines[2], sizeof(lines[2]), "GPU  %.2f / %.2f / %.2f", gpu.p50, gpu.p95, gpu.p99);
+    }
+    else {
+        snprintf(lines[2], sizeof(lines[2]), "GPU  no timer queries");
+    }
+    snprintf(lines[3], sizeof(lines[3]), "triangles %d  chunks %d  culled %d",
+        last.triangles, last.chunks, last.culledChunks);
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POLYGON_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, width, 0, height, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glColor3f(1.0f, 1.0f, 0.3f);
+    for (int k = 0; k < 4; ++k) {
+        glRasterPos2i(10, height - 20 - 16 * k);
+        for (const char* c = lines[k]; *c != '\0'; ++c) {
+            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+        }
+    }
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
+
+void FrameProfiler::finish() {
+    if (timerQueries) {
+        poll(true);
+    }
+}
+
+bool FrameProfiler::writeCSV(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка создания файла " << path << std::endl;
+        return false;
+    }
+    file << "frame,cpu_ms,gpu_ms,triangles,chunks,culled_chunks\n";
+    for (size_t k = 0; k < history.size(); ++k) {
+        const Sample& sample = history[k];
+        file << k << "," << sample.cpu << ",";
+        if (sample.gpu >= 0.0) {
+            file << sample.gpu;
+        }
+        file << "," << sample.triangles << "," << sample.chunks << "," << sample.culledChunks << "\n";
+    }
+    if (!file) {
+        std::cerr << "Ошибка записи в файл " << path << std::endl;
+        return false;
+    }
+    std::cout << "Профиль кадров окна: " << path << " (" << history.size() << " кадров)" << std::endl;
+    return true;
+}
+
+void FrameProfiler::printSummary() const {
+    if (history.empty()) {
+        return;
+    }
+    const Percentiles cpu = percentiles(&Sample::cpu, history.size());
+    const Percentiles gpu = percentiles(&Sample::gpu, history.size());
+    std::cout << "Кадров: " << history.size() << ", CPU p50/p95/p99: "
+        << cpu.p50 << " / " << cpu.p95 << " / " << cpu.p99 << " мс";
+    if (gpu.count > 0) {
+        std::cout << ", GPU: " << gpu.p50 << " / " << gpu.p95 << " / " << gpu.p99 << " мс";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Профиль кадров OpenGL-окна: время CPU (от начала display до обмена
+// буферов), время GPU по запросам GL_TIME_ELAPSED, треугольники и
+// фрагменты LOD. Результат запроса забирается, когда готов (через
+// несколько кадров), поэтому кадр GPU не ждет; без таймеров время GPU
+// не известно. Процентили - по последним WINDOW кадрам, вся история
+// пишется в CSV при выходе.
+class FrameProfiler {
+public:
+    // Нужен текущий контекст GL
+    void initialize();
+    void release();
+
+    void beginFrame();
+    void endFrame(int triangles, int chunks, int culledChunks);
+
+    // Статистика текстом GLUT в левом верхнем углу окна
+    void drawOverlay(int width, int height) const;
+
+    // Дожидается результатов запросов GPU; перед выводом при выходе
+    void finish();
+    // Строки: кадр, CPU, GPU (мс), треугольники, фрагменты
+    bool writeCSV(const std::string& path) const;
+    void printSummary() const;
+
+private:
+    static const int QUERIES = 4;
+    static const int WINDOW = 240;
+
+    struct Sample {
+        double cpu;          // мс
+        double gpu;          // мс, < 0 - не измерено
+        int triangles;
+        int chunks;
+        int culledChunks;
+    };
+
+    struct Query {
+        unsigned int id = 0;
+        long long frame = -1; // кадр, чей результат еще не забран
+    };
+
+    struct Percentiles {
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+        int count = 0;
+    };
+
+    void poll(bool wait);
+    Percentiles percentiles(double Sample::* value, size_t window) const;
+
+    std::vector<Sample> history;
+    Query queries[QUERIES];
+    int nextQuery = 0;
+    bool timerQueries = false;
+    bool queryActive = false;
+    bool firstResult = true;
+    std::chrono::steady_clock::time_point frameStart;
+};
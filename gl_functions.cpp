@@ -0,0 +1,128 @@
+#include "gl_functions.h"
+#include <GL/freeglut.h>
+#include <cstdio>
+#include <cstring>
+
+GLFunctions::Loader GLFunctions::loader = nullptr;
+
+GLFunctions::GenBuffersProc GLFunctions::genBuffers = nullptr;
+GLFunctions::DeleteBuffersProc GLFunctions::deleteBuffers = nullptr;
+GLFunctions::BindBufferProc GLFunctions::bindBuffer = nullptr;
+GLFunctions::BufferDataProc GLFunctions::bufferData = nullptr;
+GLFunctions::MapBufferProc GLFunctions::mapBuffer = nullptr;
+GLFunctions::UnmapBufferProc GLFunctions::unmapBuffer = nullptr;
+
+GLFunctions::GenQueriesProc GLFunctions::genQueries = nullptr;
+GLFunctions::DeleteQueriesProc GLFunctions::deleteQueries = nullptr;
+GLFunctions::BeginQueryProc GLFunctions::beginQuery = nullptr;
+GLFunctions::EndQueryProc GLFunctions::endQuery = nullptr;
+GLFunctions::GetQueryObjectivProc GLFunctions::getQueryObjectiv = nullptr;
+GLFunctions::GetQueryObjectui64vProc GLFunctions::getQueryObjectui64v = nullptr;
+
+GLFunctions::GenFramebuffersProc GLFunctions::genFramebuffers = nullptr;
+GLFunctions::DeleteFramebuffersProc GLFunctions::deleteFramebuffers = nullptr;
+GLFunctions::BindFramebufferProc GLFunctions::bindFramebuffer = nullptr;
+GLFunctions::CheckFramebufferStatusProc GLFunctions::checkFramebufferStatus = nullptr;
+GLFunctions::GenRenderbuffersProc GLFunctions::genRenderbuffers = nullptr;
+GLFunctions::DeleteRenderbuffersProc GLFunctions::deleteRenderbuffers = nullptr;
+GLFunctions::BindRenderbufferProc GLFunctions::bindRenderbuffer = nullptr;
+GLFunctions::RenderbufferStorageProc GLFunctions::renderbufferStorage = nullptr;
+GLFunctions::FramebufferRenderbufferProc GLFunctions::framebufferRenderbuffer = nullptr;
+
+GLFunctions::CreateShaderProc GLFunctions::createShader = nullptr;
+GLFunctions::ShaderSourceProc GLFunctions::shaderSource = nullptr;
+GLFunctions::CompileShaderProc GLFunctions::compileShader = nullptr;
+GLFunctions::GetShaderivProc GLFunctions::getShaderiv = nullptr;
+GLFunctions::GetShaderInfoLogProc GLFunctions::getShaderInfoLog = nullptr;
+GLFunctions::DeleteShaderProc GLFunctions::deleteShader = nullptr;
+GLFunctions::CreateProgramProc GLFunctions::createProgram = nullptr;
+GLFunctions::AttachShaderProc GLFunctions::attachShader = nullptr;
+GLFunctions::LinkProgramProc GLFunctions::linkProgram = nullptr;
+GLFunctions::GetProgramivProc GLFunctions::getProgramiv = nullptr;
+GLFunctions::GetProgramInfoLogProc GLFunctions::getProgramInfoLog = nullptr;
+GLFunctions::DeleteProgramProc GLFunctions::deleteProgram = nullptr;
+GLFunctions::UseProgramProc GLFunctions::useProgram = nullptr;
+GLFunctions::GetUniformLocationProc GLFunctions::getUniformLocation = nullptr;
+GLFunctions::Uniform1iProc GLFunctions::uniform1i = nullptr;
+GLFunctions::Uniform1fProc GLFunctions::uniform1f = nullptr;
+GLFunctions::Uniform3fProc GLFunctions::uniform3f = nullptr;
+
+template<class Proc>
+static bool load(Proc& proc, const char* name) {
+    if (proc == nullptr) {
+        proc = GLFunctions::loader != nullptr
+            ? reinterpret_cast<Proc>(GLFunctions::loader(name))
+            : reinterpret_cast<Proc>(glutGetProcAddress(name));
+    }
+    return proc != nullptr;
+}
+
+bool GLFunctions::loadBuffers() {
+    bool ok = load(genBuffers, "glGenBuffers");
+    ok = load(deleteBuffers, "glDeleteBuffers") && ok;
+    ok = load(bindBuffer, "glBindBuffer") && ok;
+    ok = load(bufferData, "glBufferData") && ok;
+    return ok;
+}
+
+bool GLFunctions::loadPixelBuffers() {
+    bool ok = loadBuffers();
+    ok = load(mapBuffer, "glMapBuffer") && ok;
+    ok = load(unmapBuffer, "glUnmapBuffer") && ok;
+    return ok;
+}
+
+bool GLFunctions::loadTimerQueries() {
+    // Адреса функций бывают и без поддержки драйвером - проверяется версия
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    int major = 0, minor = 0;
+    if (version == nullptr || sscanf(version, "%d.%d", &major, &minor) != 2) {
+        return false;
+    }
+    if (major * 10 + minor < 33 && (extensions == nullptr || strstr(extensions, "GL_ARB_timer_query") == nullptr)) {
+        return false;
+    }
+
+    bool ok = load(genQueries, "glGenQueries");
+    ok = load(deleteQueries, "glDeleteQueries") && ok;
+    ok = load(beginQuery, "glBeginQuery") && ok;
+    ok = load(endQuery, "glEndQuery") && ok;
+    ok = load(getQueryObjectiv, "glGetQueryObjectiv") && ok;
+    ok = load(getQueryObjectui64v, "glGetQueryObjectui64v") && ok;
+    return ok;
+}
+
+bool GLFunctions::loadFramebuffers() {
+    bool ok = load(genFramebuffers, "glGenFramebuffers");
+    ok = load(deleteFramebuffers, "glDeleteFramebuffers") && ok;
+    ok = load(bindFramebuffer, "glBindFramebuffer") && ok;
+    ok = load(checkFramebufferStatus, "glCheckFramebufferStatus") && ok;
+    ok = load(genRenderbuffers, "glGenRenderbuffers") && ok;
+    ok = load(deleteRenderbuffers, "glDeleteRenderbuffers") && ok;
+    ok = load(bindRenderbuffer, "glBindRenderbuffer") && ok;
+    ok = load(renderbufferStorage, "glRenderbufferStorage") && ok;
+    ok = load(framebufferRenderbuffer, "glFramebufferRenderbuffer") && ok;
+    return ok;
+}
+
+bool GLFunctions::loadShaders() {
+    bool ok = load(createShader, "glCreateShader");
+    ok = load(shaderSource, "glShaderSource") && ok;
+    ok = load(compileShader, "glCompileShader") && ok;
+    ok = load(getShaderiv, "glGetShaderiv") && ok;
+    ok = load(getShaderInfoLog, "glGetShaderInfoLog") && ok;
+    ok = load(deleteShader, "glDeleteShader") && ok;
+    ok = load(createProgram, "glCreateProgram") && ok;
+    ok = load(attachShader, "glAttachShader") && ok;
+    ok = load(linkProgram, "glLinkProgram") && ok;
+    ok = load(getProgramiv, "glGetProgramiv") && ok;
+    ok = load(getProgramInfoLog, "glGetProgramInfoLog") && ok;
+    ok = load(deleteProgram, "glDeleteProgram") && ok;
+    ok = load(useProgram, "glUseProgram") && ok;
+    ok = load(getUniformLocation, "glGetUniformLocation") && ok;
+    ok = load(uniform1i, "glUniform1i") && ok;
+    ok = load(uniform1f, "glUniform1f") && ok;
+    ok = load(uniform3f, "glUniform3f") && ok;
+    return ok;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Буферы вершин (OpenGL 1.5)
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+// Буферы пикселей (OpenGL 2.1)
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#define GL_STREAM_READ 0x88E1
+#endif
+
+// Запросы времени GPU (OpenGL 3.3, ARB_timer_query)
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+// Буферы кадра (OpenGL 3.0, ARB_framebuffer_object)
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_RENDERBUFFER 0x8D41
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+// Шейдеры (OpenGL 2.0)
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+typedef char GLchar;
+
+// Функции OpenGL новее 1.1 загружаются через GLUT: в opengl32.lib Windows
+// есть только OpenGL 1.1. Нужен текущий контекст.
+class GLFunctions {
+public:
+    // Загрузчик контекста без GLUT (EGL, OSMesa); nullptr - glutGetProcAddress
+    typedef void* (*Loader)(const char* name);
+    static Loader loader;
+
+    typedef void (APIENTRY* GenBuffersProc)(GLsizei n, GLuint* buffers);
+    typedef void (APIENTRY* DeleteBuffersProc)(GLsizei n, const GLuint* buffers);
+    typedef void (APIENTRY* BindBufferProc)(GLenum target, GLuint buffer);
+    typedef void (APIENTRY* BufferDataProc)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+    typedef void* (APIENTRY* MapBufferProc)(GLenum target, GLenum access);
+    typedef GLboolean (APIENTRY* UnmapBufferProc)(GLenum target);
+
+    typedef void (APIENTRY* GenQueriesProc)(GLsizei n, GLuint* ids);
+    typedef void (APIENTRY* DeleteQueriesProc)(GLsizei n, const GLuint* ids);
+    typedef void (APIENTRY* BeginQueryProc)(GLenum target, GLuint id);
+    typedef void (APIENTRY* EndQueryProc)(GLenum target);
+    typedef void (APIENTRY* GetQueryObjectivProc)(GLuint id, GLenum name, GLint* value);
+    typedef void (APIENTRY* GetQueryObjectui64vProc)(GLuint id, GLenum name, uint64_t* value);
+
+    typedef void (APIENTRY* GenFramebuffersProc)(GLsizei n, GLuint* ids);
+    typedef void (APIENTRY* DeleteFramebuffersProc)(GLsizei n, const GLuint* ids);
+    typedef void (APIENTRY* BindFramebufferProc)(GLenum target, GLuint id);
+    typedef GLenum (APIENTRY* CheckFramebufferStatusProc)(GLenum target);
+    typedef void (APIENTRY* GenRenderbuffersProc)(GLsizei n, GLuint* ids);
+    typedef void (APIENTRY* DeleteRenderbuffersProc)(GLsizei n, const GLuint* ids);
+    typedef void (APIENTRY* BindRenderbufferProc)(GLenum target, GLuint id);
+    typedef void (APIENTRY* RenderbufferStorageProc)(GLenum target, GLenum format, GLsizei width, GLsizei height);
+    typedef void (APIENTRY* FramebufferRenderbufferProc)(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer);
+
+    typedef GLuint (APIENTRY* CreateShaderProc)(GLenum type);
+    typedef void (APIENTRY* ShaderSourceProc)(GLuint shader, GLsizei count, const GLchar* const* source, const GLint* length);
+    typedef void (APIENTRY* CompileShaderProc)(GLuint shader);
+    typedef void (APIENTRY* GetShaderivProc)(GLuint shader, GLenum name, GLint* value);
+    typedef void (APIENTRY* GetShaderInfoLogProc)(GLuint shader, GLsizei size, GLsizei* length, GLchar* log);
+    typedef void (APIENTRY* DeleteShaderProc)(GLuint shader);
+    typedef GLuint (APIENTRY* CreateProgramProc)();
+    typedef void (APIENTRY* AttachShaderProc)(GLuint program, GLuint shader);
+    typedef void (APIENTRY* LinkProgramProc)(GLuint program);
+    typedef void (APIENTRY* GetProgramivProc)(GLuint program, GLenum name, GLint* value);
+    typedef void (APIENTRY* GetProgramInfoLogProc)(GLuint program, GLsizei size, GLsizei* length, GLchar* log);
+    typedef void (APIENTRY* DeleteProgramProc)(GLuint program);
+    typedef void (APIENTRY* UseProgramProc)(GLuint program);
+    typedef GLint (APIENTRY* GetUniformLocationProc)(GLuint program, const GLchar* name);
+    typedef void (APIENTRY* Uniform1iProc)(GLint location, GLint value);
+    typedef void (APIENTRY* Uniform1fProc)(GLint location, GLfloat value);
+    typedef void (APIENTRY* Uniform3fProc)(GLint location, GLfloat x, GLfloat y, GLfloat z);
+
+    static GenBuffersProc genBuffers;
+    static DeleteBuffersProc deleteBuffers;
+    static BindBufferProc bindBuffer;
+    static BufferDataProc bufferData;
+    static MapBufferProc mapBuffer;
+    static UnmapBufferProc unmapBuffer;
+
+    static GenQueriesProc genQueries;
+    static DeleteQueriesProc deleteQueries;
+    static BeginQueryProc beginQuery;
+    static EndQueryProc endQuery;
+    static GetQueryObjectivProc getQueryObjectiv;
+    static GetQueryObjectui64vProc getQueryObjectui64v;
+
+    static GenFramebuffersProc genFramebuffers;
+    static DeleteFramebuffersProc deleteFramebuffers;
+    static BindFramebufferProc bindFramebuffer;
+    static CheckFramebufferStatusProc checkFramebufferStatus;
+    static GenRenderbuffersProc genRenderbuffers;
+    static DeleteRenderbuffersProc deleteRenderbuffers;
+    static BindRenderbufferProc bindRenderbuffer;
+    static RenderbufferStorageProc renderbufferStorage;
+    static FramebufferRenderbufferProc framebufferRenderbuffer;
+
+    static CreateShaderProc createShader;
+    static ShaderSourceProc shaderSource;
+    static CompileShaderProc compileShader;
+    static GetShaderivProc getShaderiv;
+    static GetShaderInfoLogProc getShaderInfoLog;
+    static DeleteShaderProc deleteShader;
+    static CreateProgramProc createProgram;
+    static AttachShaderProc attachShader;
+    static LinkProgramProc linkProgram;
+    static GetProgramivProc getProgramiv;
+    static GetProgramInfoLogProc getProgramInfoLog;
+    static DeleteProgramProc deleteProgram;
+    static UseProgramProc useProgram;
+    static GetUniformLocationProc getUniformLocation;
+    static Uniform1iProc uniform1i;
+    static Uniform1fProc uniform1f;
+    static Uniform3fProc uniform3f;
+
+    // true, если есть все функции буферов вершин
+    static bool loadBuffers();
+    // true, если есть еще и отображение буферов в память (чтение через PBO)
+    static bool loadPixelBuffers();
+    // true, если есть запросы времени GPU
+    static bool loadTimerQueries();
+    // true, если есть буферы кадра (рендер без окна)
+    static bool loadFramebuffers();
+    // true, если есть все функции шейдеров GLSL
+    static bool loadShaders();
+};
@@ -0,0 +1,248 @@
+#include "heightfield.h"
+#include "parallel_utils.h"
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+
+Heightfield Heightfield::fromDepth(const std::vector<std::vector<double>>& depthData, float scale) {
+    Heightfield field;
+    field.rows = static_cast<int>(depthData.size());
+    field.cols = field.rows > 0 ? static_cast<int>(depthData[0].size()) : 0;
+
+    // Масштаб по глубине как в визуализаторе и рендере
+    double maxDepth = 1.0;
+    for (const auto& row : depthData) {
+        for (double depth : row) {
+            if (depth > maxDepth) maxDepth = depth;
+        }
+    }
+    const float zScale = scale / static_cast<float>(maxDepth);
+
+    const size_t count = static_cast<size_t>(field.rows) * field.cols;
+    field.height.resize(count);
+    field.valid.resize(count);
+    parallelFor(0, field.rows, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            const double* src = depthData[i].data();
+            const size_t row = static_cast<size_t>(i) * field.cols;
+            for (int j = 0; j < field.cols; ++j) {
+                field.height[row + j] = -static_cast<float>(src[j]) * zScale;
+                field.valid[row + j] = src[j] > 0.0 ? 1 : 0;
+            }
+        }
+    }, 16);
+    return field;
+}
+
+void Heightfield::normal(int i, int j, float& nx, float& ny, float& nz) const {
+    const size_t v = static_cast<size_t>(i) * cols + j;
+    const float z = height[v];
+    float dzdj = 0.0f, dzdi = 0.0f;
+    const bool left = j > 0 && valid[v - 1];
+    const bool right = j + 1 < cols && valid[v + 1];
+    const bool up = i > 0 && valid[v - cols];
+    const bool down = i + 1 < rows && valid[v + cols];
+    if (left && right) dzdj = (height[v + 1] - height[v - 1]) * 0.5f;
+    else if (right) dzdj = height[v + 1] - z;
+    else if (left) dzdj = z - height[v - 1];
+    if (up && down) dzdi = (height[v + cols] - height[v - cols]) * 0.5f;
+    else if (down) dzdi = height[v + cols] - z;
+    else if (up) dzdi = z - height[v - cols];
+
+    // Касательные (1/cols, 0, dzdj) и (0, -1/rows, dzdi)
+    nx = -dzdj * cols;
+    ny = dzdi * rows;
+    const float inv = 1.0f / sqrtf(nx * nx + ny * ny + 1.0f);
+    nx *= inv;
+    ny *= inv;
+    nz = inv;
+}
+
+void HeightfieldLighting::shadowMask(const Heightfield& field, const Vector3& lightDir,
+    std::vector<float>& mask) {
+    const int rows = field.rows;
+    const int cols = field.cols;
+    mask.assign(static_cast<size_t>(rows) * cols, 1.0f);
+    if (rows < 2 || cols < 2) return;
+
+    const float length = sqrtf(lightDir.x * lightDir.x + lightDir.y * lightDir.y + lightDir.z * lightDir.z);
+    const float horizontal = sqrtf(lightDir.x * lightDir.x + lightDir.y * lightDir.y);
+    if (length < 1e-6f || horizontal < 1e-6f * length) {
+        return; // свет сверху: теней на поле высот нет
+    }
+
+    // Азимут на источник в сцене и наклон луча света
+    const float dx = lightDir.x / horizontal;
+    const float dy = lightDir.y / horizontal;
+    const float slope = lightDir.z / horizontal;
+
+    // Тот же азимут в индексах сетки. Ведущая ось (major) - с большим шагом,
+    // линия k проходит через minor = k + major * drift
+    const float dj = dx * cols;
+    const float di = -dy * rows;
+    const bool alongColumns = fabsf(dj) >= fabsf(di);
+    const int steps = alongColumns ? cols : rows;
+    const int across = alongColumns ? rows : cols;
+    const bool reverse = alongColumns ? dj > 0.0f : di > 0.0f; // источник со стороны больших индексов
+    const float drift = alongColumns ? di / dj : dj / di;
+
+    const float shift = (steps - 1) * drift;
+    const int firstLine = static_cast<int>(floorf(std::min(0.0f, -shift)));
+    const int lastLine = across - 1 + static_cast<int>(ceilf(std::max(0.0f, -shift)));
+
+    auto indexOf = [&](int major, int minor) {
+        return alongColumns ? static_cast<size_t>(minor) * cols + major
+                            : static_cast<size_t>(major) * cols + minor;
+    };
+    // h - t * tg: отсчет ниже максимума этой величины у точек ближе к
+    // источнику на той же линии находится в тени
+    auto levelAt = [&](float major, float minor, float height) {
+        const float i = alongColumns ? minor : major;
+        const float j = alongColumns ? major : minor;
+        const float t = (j - cols / 2.0f) / cols * dx + (rows / 2.0f - i) / rows * dy;
+        return height - t * slope;
+    };
+
+    // Допуск против самозатенения на освещенных склонах
+    const float bias = 1e-4f * std::max(1.0f / cols, 1.0f / rows);
+    const float none = -std::numeric_limits<float>::infinity();
+
+    // Линии делятся на полосы; полоса [kb, ke] ведет свои линии и еще одну
+    // соседнюю и пишет отсчеты, лежащие между ее линиями
+    const int lineCount = lastLine - firstLine + 1;
+    parallelFor(0, lineCount, [&](int bandBegin, int bandEnd) {
+        const int kb = firstLine + bandBegin;
+        const int ke = firstLine + bandEnd - 1;
+        std::vector<float> horizon(ke - kb + 2, none);
+
+        for (int s = 0; s < steps; ++s) {
+            const int major = reverse ? steps - 1 - s : s;
+            const float offset = major * drift;
+
+            // Приемники: отсчеты столбца с floor(minor - offset) в [kb, ke]
+            const int minorBegin = std::max(0, static_cast<int>(ceilf(kb + offset)));
+            const int minorEnd = std::min(across, static_cast<int>(ceilf(ke + 1 + offset)));
+            for (int minor = minorBegin; minor < minorEnd; ++minor) {
+                const size_t index = indexOf(major, minor);
+                if (!field.valid[index]) continue;
+
+                const float k = minor - offset;
+                const int k0 = std::min(std::max(static_cast<int>(floorf(k)), kb), ke);
+                const float f = k - k0;
+                const float h0 = horizon[k0 - kb];
+                const float h1 = horizon[k0 - kb + 1];
+                float occluder = none;
+                if (h0 > none && h1 > none) occluder = h0 + (h1 - h0) * f;
+                else if (h0 > none) occluder = h0;
+                else if (h1 > none) occluder = h1;
+
+                if (levelAt(static_cast<float>(major), static_cast<float>(minor), field.height[index]) < occluder - bias) {
+                    mask[index] = 0.0f;
+                }
+            }
+
+            // Затем столбец становится преградой для следующих: высота на
+            // точной линии интерполируется между соседними отсчетами
+            for (int k = kb; k <= ke + 1; ++k) {
+                const float minor = k + offset;
+                if (minor < 0.0f || minor > across - 1.0f) continue;
+                const int m0 = std::min(static_cast<int>(minor), across - 2);
+                const float f = minor - m0;
+                const size_t a = indexOf(major, m0);
+                const size_t b = indexOf(major, m0 + 1);
+                float height;
+                if (field.valid[a] && field.valid[b]) height = field.height[a] + (field.height[b] - field.height[a]) * f;
+                else if (field.valid[a] && f < 0.5f) height = field.height[a];
+                else if (field.valid[b] && f >= 0.5f) height = field.height[b];
+                else continue;
+
+                float& h = horizon[k - kb];
+                h = std::max(h, levelAt(static_cast<float>(major), minor, height));
+            }
+        }
+    }, 16);
+}
+
+void HeightfieldLighting::ambientOcclusion(const Heightfield& field, int directions, float radius,
+    std::vector<float>& occlusion) {
+    const int rows = field.rows;
+    const int cols = field.cols;
+    occlusion.assign(static_cast<size_t>(rows) * cols, 1.0f);
+    if (rows == 0 || cols == 0 || directions <= 0 || radius < 1.0f) return;
+
+    // Шаги по каждому азимуту: смещение в отсчетах и расстояние в сцене
+    struct Step {
+        int di, dj;
+        float distance2;
+    };
+    std::vector<std::vector<Step>> paths(directions);
+    for (int d = 0; d < directions; ++d) {
+        const float angle = (d + 0.5f) * 6.28318531f / directions;
+        const float cx = cosf(angle), cy = sinf(angle);
+        for (float r = 1.0f; r <= radius; r = std::max(r + 1.0f, r * 1.35f)) {
+            const int dj = static_cast<int>(lroundf(cx * r));
+            const int di = static_cast<int>(lroundf(-cy * r));
+            if (!paths[d].empty() && paths[d].back().di == di && paths[d].back().dj == dj) continue;
+            const float wx = static_cast<float>(dj) / cols;
+            const float wy = static_cast<float>(di) / rows;
+            paths[d].push_back({ di, dj, wx * wx + wy * wy });
+        }
+    }
+
+    const int TILE = 64;
+    const int tilesX = (cols + TILE - 1) / TILE;
+    const int tileCount = tilesX * ((rows + TILE - 1) / TILE);
+    const float invDirections = 1.0f / directions;
+    std::atomic<int> nextTile(0);
+
+    parallelFor(0, workerCount(), [&](int, int) {
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            const int i0 = (tile / tilesX) * TILE;
+            const int j0 = (tile % tilesX) * TILE;
+            const int i1 = std::min(rows, i0 + TILE);
+            const int j1 = std::min(cols, j0 + TILE);
+
+            for (int i = i0; i < i1; ++i) {
+                for (int j = j0; j < j1; ++j) {
+                    const size_t index = static_cast<size_t>(i) * cols + j;
+                    if (!field.valid[index]) continue;
+                    const float h = field.height[index];
+
+                    float occluded = 0.0f;
+                    for (const auto& path : paths) {
+                        float horizon = 0.0f; // sin угла горизонта
+                        for (const Step& step : path) {
+                            const int qi = i + step.di;
+                            const int qj = j + step.dj;
+                            if (qi < 0 || qi >= rows || qj < 0 || qj >= cols) break;
+                            const size_t q = static_cast<size_t>(qi) * cols + qj;
+                            if (!field.valid[q]) continue;
+                            const float dz = field.height[q] - h;
+                            if (dz <= 0.0f) continue;
+                            horizon = std::max(horizon, dz / sqrtf(dz * dz + step.distance2));
+                        }
+                        occluded += horizon;
+                    }
+                    occlusion[index] = 1.0f - occluded * invDirections;
+                }
+            }
+        }
+    }, 1);
+}
+
+float HeightfieldLighting::sample(const Heightfield& field, const std::vector<float>& values,
+    float x, float y) {
+    const float gj = std::min(std::max(x * field.cols + field.cols / 2.0f, 0.0f), field.cols - 1.0f);
+    const float gi = std::min(std::max(field.rows / 2.0f - y * field.rows, 0.0f), field.rows - 1.0f);
+    const int j0 = std::min(static_cast<int>(gj), field.cols - 2);
+    const int i0 = std::min(static_cast<int>(gi), field.rows - 2);
+    const float tj = gj - j0;
+    const float ti = gi - i0;
+
+    const size_t index = static_cast<size_t>(i0) * field.cols + j0;
+    const float top = values[index] + (values[index + 1] - values[index]) * tj;
+    const float bottom = values[index + field.cols]
+        + (values[index + field.cols + 1] - values[index + field.cols]) * tj;
+    return top + (bottom - top) * ti;
+}
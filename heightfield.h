@@ -0,0 +1,47 @@
+#pragma once
+
+#include "config_reader.h"
+#include <vector>
+#include <cstdint>
+
+// Карта глубины как поле высот в координатах сцены рендера:
+// x = (j - cols/2) / cols, y = (rows/2 - i) / rows, z = -depth / maxDepth * scale
+struct Heightfield {
+    int rows = 0;
+    int cols = 0;
+    std::vector<float> height;    // z, построчно
+    std::vector<uint8_t> valid;   // глубина > 0 (не фон)
+
+    static Heightfield fromDepth(const std::vector<std::vector<double>>& depthData, float scale);
+
+    float x(int j) const { return (j - cols / 2.0f) / cols; }
+    float y(int i) const { return (rows / 2.0f - i) / rows; }
+    bool empty() const { return height.empty(); }
+
+    // Нормированная нормаль в отсчете: центральные разности, у края и
+    // фона - односторонние
+    void normal(int i, int j, float& nx, float& ny, float& nz) const;
+};
+
+// Освещение, зависящее от формы поля высот целиком
+class HeightfieldLighting {
+public:
+    // Маска жестких теней от направленного источника (1 - освещено, 0 - тень).
+    // Сетка обходится линиями вдоль азимута света от источника, для каждой
+    // линии хранится максимум h - t * tg(высоты света), где t - расстояние
+    // вдоль азимута, а h интерполируется на точной линии. Отсчет сравнивается
+    // с порогом двух соседних линий: O(1) на отсчет, полосы линий параллельно.
+    static void shadowMask(const Heightfield& field, const Vector3& lightDir,
+        std::vector<float>& mask);
+
+    // Фоновое затенение (1 - открыто, 0 - закрыто): по directions азимутам
+    // ищется наибольший угол горизонта в пределах radius отсчетов, шаги
+    // растут геометрически. AO = 1 - среднее sin(горизонта). Сетка делится
+    // на тайлы, которые разбираются потоками динамически.
+    static void ambientOcclusion(const Heightfield& field, int directions, float radius,
+        std::vector<float>& occlusion);
+
+    // Билинейная выборка значения по отсчетам поля в точке сцены (x, y)
+    static float sample(const Heightfield& field, const std::vector<float>& values,
+        float x, float y);
+};
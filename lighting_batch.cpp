@@ -0,0 +1,384 @@
+#include "lighting_batch.h"
+#include "brdf_lut.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIGHTING_BATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+// Геометрия освещения, не зависящая от сэмпла: считается один раз на пакет
+struct FrameConstants {
+    float lx, ly, lz;
+    float vx, vy, vz;
+    float hx, hy, hz;
+    float VdotH;
+    bool twoSided;
+};
+}
+
+// ---------------------------------------------------------------------------
+// Скалярное ядро (остаток пакета и процессоры без SIMD)
+// ---------------------------------------------------------------------------
+
+namespace simd_scalar {
+
+typedef float V;
+typedef bool M;
+typedef int32_t I;
+static const size_t W = 1;
+
+static inline V set1(float a) { return a; }
+static inline V load(const float* p) { return *p; }
+static inline void store(float* p, V v) { *p = v; }
+static inline V add(V a, V b) { return a + b; }
+static inline V sub(V a, V b) { return a - b; }
+static inline V mul(V a, V b) { return a * b; }
+static inline V div(V a, V b) { return a / b; }
+static inline V fmadd(V a, V b, V c) { return a * b + c; }
+static inline V fnmadd(V a, V b, V c) { return c - a * b; }
+static inline V vmin(V a, V b) { return a < b ? a : b; }
+static inline V vmax(V a, V b) { return a > b ? a : b; }
+static inline V vsqrt(V a) { return sqrtf(a); }
+static inline V vround(V a) { return nearbyintf(a); }
+static inline M lt(V a, V b) { return a < b; }
+static inline M le(V a, V b) { return a <= b; }
+static inline M gt(V a, V b) { return a > b; }
+static inline M mor(M a, M b) { return a || b; }
+static inline V select(M m, V a, V b) { return m ? a : b; }
+static inline I toIndex(V a) { return static_cast<int32_t>(a); }
+static inline V indexToFloat(I i) { return static_cast<float>(i); }
+static inline V gather(const float* table, I i) { return table[i]; }
+
+static inline V pow2n(V n) {
+    const uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static inline V vfrexp(V x, V& e) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    e = static_cast<float>(static_cast<int32_t>((bits >> 23) & 0xff) - 126);
+    bits = (bits & 0x807fffffu) | 0x3f000000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return m;
+}
+
+#include "lighting_kernels.inl"
+
+}
+
+#ifdef LIGHTING_BATCH_X86
+
+// ---------------------------------------------------------------------------
+// SSE2, 4 сэмпла
+// ---------------------------------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace simd_sse2 {
+
+typedef __m128 V;
+typedef __m128 M;
+typedef __m128i I;
+static const size_t W = 4;
+
+static inline V set1(float a) { return _mm_set1_ps(a); }
+static inline V load(const float* p) { return _mm_loadu_ps(p); }
+static inline void store(float* p, V v) { _mm_storeu_ps(p, v); }
+static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+static inline V div(V a, V b) { return _mm_div_ps(a, b); }
+static inline V fmadd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline V fnmadd(V a, V b, V c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+static inline V vmin(V a, V b) { return _mm_min_ps(a, b); }
+static inline V vmax(V a, V b) { return _mm_max_ps(a, b); }
+static inline V vsqrt(V a) { return _mm_sqrt_ps(a); }
+static inline V vround(V a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+static inline M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+static inline M le(V a, V b) { return _mm_cmple_ps(a, b); }
+static inline M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+static inline M mor(M a, M b) { return _mm_or_ps(a, b); }
+static inline V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+static inline I toIndex(V a) { return _mm_cvttps_epi32(a); }
+static inline V indexToFloat(I i) { return _mm_cvtepi32_ps(i); }
+
+// В SSE2 нет gather: индексы выгружаются и читаются по одному
+static inline V gather(const float* table, I i) {
+    alignas(16) int32_t k[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(k), i);
+    return _mm_setr_ps(table[k[0]], table[k[1]], table[k[2]], table[k[3]]);
+}
+
+static inline V pow2n(V n) {
+    const __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+static inline V vfrexp(V x, V& e) {
+    const __m128i bits = _mm_castps_si128(x);
+    const __m128i exponent = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff));
+    e = _mm_cvtepi32_ps(_mm_sub_epi32(exponent, _mm_set1_epi32(126)));
+    const __m128i mantissa = _mm_and_si128(bits, _mm_set1_epi32(static_cast<int>(0x807fffffu)));
+    return _mm_castsi128_ps(_mm_or_si128(mantissa, _mm_set1_epi32(0x3f000000)));
+}
+
+#include "lighting_kernels.inl"
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA, 8 сэмплов
+// ---------------------------------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace simd_avx2 {
+
+typedef __m256 V;
+typedef __m256 M;
+typedef __m256i I;
+static const size_t W = 8;
+
+static inline V set1(float a) { return _mm256_set1_ps(a); }
+static inline V load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+static inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+static inline V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+static inline V fnmadd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+static inline V vmin(V a, V b) { return _mm256_min_ps(a, b); }
+static inline V vmax(V a, V b) { return _mm256_max_ps(a, b); }
+static inline V vsqrt(V a) { return _mm256_sqrt_ps(a); }
+static inline V vround(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+static inline M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline M le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline M mor(M a, M b) { return _mm256_or_ps(a, b); }
+static inline V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+static inline I toIndex(V a) { return _mm256_cvttps_epi32(a); }
+static inline V indexToFloat(I i) { return _mm256_cvtepi32_ps(i); }
+static inline V gather(const float* table, I i) { return _mm256_i32gather_ps(table, i, 4); }
+
+static inline V pow2n(V n) {
+    const __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+
+static inline V vfrexp(V x, V& e) {
+    const __m256i bits = _mm256_castps_si256(x);
+    const __m256i exponent = _mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff));
+    e = _mm256_cvtepi32_ps(_mm256_sub_epi32(exponent, _mm256_set1_epi32(126)));
+    const __m256i mantissa = _mm256_and_si256(bits, _mm256_set1_epi32(static_cast<int>(0x807fffffu)));
+    return _mm256_castsi256_ps(_mm256_or_si256(mantissa, _mm256_set1_epi32(0x3f000000)));
+}
+
+#include "lighting_kernels.inl"
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// ---------------------------------------------------------------------------
+// AVX-512F, 16 сэмплов
+// ---------------------------------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// _mm512_undefined_ps() в avx512fintrin.h дает ложные -Wmaybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace simd_avx512 {
+
+typedef __m512 V;
+typedef __mmask16 M;
+typedef __m512i I;
+static const size_t W = 16;
+
+static inline V set1(float a) { return _mm512_set1_ps(a); }
+static inline V load(const float* p) { return _mm512_loadu_ps(p); }
+static inline void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+static inline V add(V a, V b) { return _mm512_add_ps(a, b); }
+static inline V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+static inline V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+static inline V div(V a, V b) { return _mm512_div_ps(a, b); }
+static inline V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+static inline V fnmadd(V a, V b, V c) { return _mm512_fnmadd_ps(a, b, c); }
+static inline V vmin(V a, V b) { return _mm512_min_ps(a, b); }
+static inline V vmax(V a, V b) { return _mm512_max_ps(a, b); }
+static inline V vsqrt(V a) { return _mm512_sqrt_ps(a); }
+static inline V vround(V a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+static inline M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+static inline M le(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+static inline M gt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+static inline M mor(M a, M b) { return static_cast<M>(a | b); }
+static inline V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+static inline I toIndex(V a) { return _mm512_cvttps_epi32(a); }
+static inline V indexToFloat(I i) { return _mm512_cvtepi32_ps(i); }
+static inline V gather(const float* table, I i) { return _mm512_i32gather_ps(i, table, 4); }
+
+static inline V pow2n(V n) {
+    const __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+}
+
+static inline V vfrexp(V x, V& e) {
+    const __m512i bits = _mm512_castps_si512(x);
+    const __m512i exponent = _mm512_and_si512(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(0xff));
+    e = _mm512_cvtepi32_ps(_mm512_sub_epi32(exponent, _mm512_set1_epi32(126)));
+    const __m512i mantissa = _mm512_and_si512(bits, _mm512_set1_epi32(static_cast<int>(0x807fffffu)));
+    return _mm512_castsi512_ps(_mm512_or_si512(mantissa, _mm512_set1_epi32(0x3f000000)));
+}
+
+#include "lighting_kernels.inl"
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+#endif // LIGHTING_BATCH_X86
+
+// ---------------------------------------------------------------------------
+// Определение возможностей процессора и диспетчеризация
+// ---------------------------------------------------------------------------
+
+static SimdLevel queryCpu() {
+#if !defined(LIGHTING_BATCH_X86)
+    return SimdLevel::SCALAR;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!sse2) return SimdLevel::SCALAR;
+    if (!osxsave || !avx || !fma || maxLeaf < 7) return SimdLevel::SSE2;
+
+    // ОС должна сохранять регистры YMM (и ZMM для AVX-512)
+    const unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return SimdLevel::SSE2;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (avx512f && avx2 && (xcr0 & 0xe6) == 0xe6) return SimdLevel::AVX512;
+    if (avx2) return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+#endif
+}
+
+SimdLevel LightingBatch::detectSimdLevel() {
+    static const SimdLevel level = queryCpu();
+    return level;
+}
+
+SimdLevel LightingBatch::levelFromName(const std::string& name) {
+    SimdLevel requested = SimdLevel::AVX512;
+    if (name == "scalar") requested = SimdLevel::SCALAR;
+    else if (name == "sse2" || name == "sse") requested = SimdLevel::SSE2;
+    else if (name == "avx2") requested = SimdLevel::AVX2;
+    return std::min(requested, detectSimdLevel());
+}
+
+const char* LightingBatch::levelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+void LightingBatch::shade(const Material& material, const ShadingParams& params,
+    const ShadingBatch& batch) {
+    shade(material, params, batch, detectSimdLevel());
+}
+
+void LightingBatch::shade(const Material& material, const ShadingParams& params,
+    const ShadingBatch& batch, SimdLevel level) {
+    const Vector3 L = brdf::normalize(params.lightDir);
+    const Vector3 V = brdf::normalize(params.viewDir);
+    const Vector3 H = brdf::normalize(L + V);
+
+    FrameConstants f;
+    f.lx = L.x; f.ly = L.y; f.lz = L.z;
+    f.vx = V.x; f.vy = V.y; f.vz = V.z;
+    f.hx = H.x; f.hy = H.y; f.hz = H.z;
+    f.VdotH = std::max(0.0f, brdf::dot(V, H));
+    f.twoSided = params.twoSided;
+
+    size_t done = 0;
+    switch (std::min(level, detectSimdLevel())) {
+#ifdef LIGHTING_BATCH_X86
+    case SimdLevel::AVX512:
+        done = batch.count - batch.count % simd_avx512::W;
+        simd_avx512::shade(material, f, batch, 0, done);
+        break;
+    case SimdLevel::AVX2:
+        done = batch.count - batch.count % simd_avx2::W;
+        simd_avx2::shade(material, f, batch, 0, done);
+        break;
+    case SimdLevel::SSE2:
+        done = batch.count - batch.count % simd_sse2::W;
+        simd_sse2::shade(material, f, batch, 0, done);
+        break;
+#endif
+    default:
+        break;
+    }
+    simd_scalar::shade(material, f, batch, done, batch.count);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "config_reader.h"
+#include "brdf.h"
+#include <cstddef>
+#include <string>
+
+// Набор инструкций для пакетного освещения
+enum class SimdLevel {
+    SCALAR = 0,
+    SSE2 = 1,
+    AVX2 = 2,
+    AVX512 = 3
+};
+
+// Геометрия освещения, общая для всего пакета (материал - отдельно)
+struct ShadingParams {
+    Vector3 lightDir;           // на источник (нормируется внутри)
+    Vector3 viewDir;            // на наблюдателя, если в пакете нет viewX/Y/Z
+    bool twoSided = false;      // разворачивать нормаль к наблюдателю
+};
+
+// Пакет сэмплов в SoA. Нормали должны быть нормированы, векторы на
+// наблюдателя (если заданы) нормируются внутри.
+// Результат: color = material.color * diffuse + specular.
+struct ShadingBatch {
+    const float* normalX = nullptr;
+    const float* normalY = nullptr;
+    const float* normalZ = nullptr;
+    const float* viewX = nullptr;
+    const float* viewY = nullptr;
+    const float* viewZ = nullptr;
+    size_t count = 0;
+    float* diffuse = nullptr;
+    float* specular = nullptr;
+};
+
+// Пакетный вариант LightingModel::calculateColor: ядро выбирается один раз
+// на пакет по модели материала и набору возможностей (общий или попиксельный
+// viewDir, двустороннее освещение), сэмплы обрабатываются по 4/8/16 за раз
+// (SSE2/AVX2/AVX-512), остаток - скалярным ядром. exp и pow вычисляются
+// полиномиальными приближениями: относительная ошибка exp не больше 2e-7
+// на [-87, 88], pow(x, s) = exp(s * ln x) - не больше 2e-7 * (1 + |s ln x|).
+class LightingBatch {
+public:
+    static void shade(const Material& material, const ShadingParams& params,
+        const ShadingBatch& batch);
+    static void shade(const Material& material, const ShadingParams& params,
+        const ShadingBatch& batch, SimdLevel level);
+
+    // Лучший набор инструкций, поддерживаемый процессором и ОС
+    static SimdLevel detectSimdLevel();
+
+    // "auto", "scalar", "sse2", "avx2", "avx512"; не выше поддерживаемого
+    static SimdLevel levelFromName(const std::string& name);
+    static const char* levelName(SimdLevel level);
+};
@@ -0,0 +1,122 @@
+#include "lighting_benchmark.h"
+#include "lighting_batch.h"
+#include "brdf_lut.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+
+// Нормали, равномерно распределенные по полусфере к наблюдателю
+struct SampleSet {
+    std::vector<float> x, y, z;
+
+    explicit SampleSet(size_t count) : x(count), y(count), z(count) {
+        uint32_t state = 12345u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        };
+        for (size_t i = 0; i < count; ++i) {
+            const float cosTheta = next();
+            const float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+            const float phi = next() * 6.2831853f;
+            x[i] = sinTheta * cosf(phi);
+            y[i] = sinTheta * sinf(phi);
+            z[i] = cosTheta;
+        }
+    }
+};
+
+struct Result {
+    std::vector<float> diffuse, specular;
+    double ms = 0.0;
+};
+
+// Лучшее время из нескольких прогонов
+Result measure(const Material& material, const ShadingParams& params,
+    const SampleSet& samples, SimdLevel level) {
+    const size_t count = samples.x.size();
+    Result result;
+    result.diffuse.resize(count);
+    result.specular.resize(count);
+
+    ShadingBatch batch;
+    batch.normalX = samples.x.data();
+    batch.normalY = samples.y.data();
+    batch.normalZ = samples.z.data();
+    batch.count = count;
+    batch.diffuse = result.diffuse.data();
+    batch.specular = result.specular.data();
+
+    result.ms = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        LightingBatch::shade(material, params, batch, level);
+        result.ms = std::min(result.ms, std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    return result;
+}
+
+// Максимальная ошибка, отнесенная к максимуму эталона
+float relativeError(const std::vector<float>& value, const std::vector<float>& reference) {
+    float error = 0.0f, peak = 0.0f;
+    for (size_t i = 0; i < value.size(); ++i) {
+        error = std::max(error, std::fabs(value[i] - reference[i]));
+        peak = std::max(peak, std::fabs(reference[i]));
+    }
+    return peak > 0.0f ? error / peak : error;
+}
+
+}
+
+void LightingBenchmark::run(const Config& config, size_t sampleCount) {
+    const SampleSet samples(sampleCount);
+    ShadingParams params;
+    params.lightDir = config.light_direction;
+    params.viewDir = Vector3(0.0f, 0.0f, 1.0f);
+
+    std::cout << "\nСравнение таблиц BRDF с аналитикой: " << sampleCount << " сэмплов, "
+        << "таблицы по " << (BRDFTables::kSize + 1) << " узлов" << std::endl;
+
+    for (int model = 1; model <= 2; ++model) {
+        Material material = Material::fromConfig(config);
+        material.model = model;
+
+        const auto start = std::chrono::steady_clock::now();
+        const BRDFTables tables = BRDFTables::build(material);
+        const double buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (model == 1 ? "Фонг-Блинн" : "Торренс-Сперроу")
+            << ": построение таблиц " << buildMs << " мс, ошибка интерполяции D "
+            << tables.errorD << ", vis " << tables.errorVis << ", F " << tables.errorF
+            << ", блик " << tables.errorBlinn << std::endl;
+
+        const Result reference = measure(material, params, samples, SimdLevel::SCALAR);
+        Material tabulated = material;
+        tabulated.tables = &tables;
+
+        for (int l = 0; l <= static_cast<int>(LightingBatch::detectSimdLevel()); ++l) {
+            const SimdLevel level = static_cast<SimdLevel>(l);
+            const Result analytic = measure(material, params, samples, level);
+            const Result table = measure(tabulated, params, samples, level);
+
+            // Строка форматируется отдельно: флаги и точность std::cout не меняются
+            std::ostringstream row;
+            row << "  " << std::setw(8) << LightingBatch::levelName(level)
+                << ": аналитика " << std::fixed << std::setprecision(2) << analytic.ms
+                << " мс, таблицы " << table.ms << " мс (x" << analytic.ms / table.ms << ")"
+                << std::defaultfloat << std::setprecision(3)
+                << ", ошибка блика " << relativeError(table.specular, reference.specular)
+                << ", диффузной " << relativeError(table.diffuse, reference.diffuse);
+            std::cout << row.str() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "config_reader.h"
+#include <cstddef>
+
+// Сравнение табличного (BRDFTables) и аналитического пакетного освещения:
+// время на всех доступных наборах инструкций и ошибка относительно
+// аналитического скалярного результата. Материал - из конфигурации,
+// модели Фонга-Блинна и Торренса-Сперроу.
+class LightingBenchmark {
+public:
+    static void run(const Config& config, size_t sampleCount = 1 << 20);
+};
@@ -0,0 +1,231 @@
+// Ядра пакетного освещения. Файл включается в lighting_batch.cpp несколько
+// раз внутри пространства имен конкретного набора инструкций, где уже
+// определены тип вектора V, тип маски M, ширина W и примитивы над ними.
+
+// exp(x): x = n ln2 + r, |r| <= ln2/2, полином Cephes.
+// Относительная ошибка <= 2e-7 на [-87.3, 88.3], вне диапазона - насыщение.
+static inline V vexp(V x) {
+    x = vmin(vmax(x, set1(-87.3f)), set1(88.3f));
+    const V n = vround(mul(x, set1(1.44269504088896341f)));
+    V r = fnmadd(n, set1(0.693359375f), x);
+    r = fnmadd(n, set1(-2.12194440e-4f), r);
+
+    V p = set1(1.9875691500e-4f);
+    p = fmadd(p, r, set1(1.3981999507e-3f));
+    p = fmadd(p, r, set1(8.3334519073e-3f));
+    p = fmadd(p, r, set1(4.1665795894e-2f));
+    p = fmadd(p, r, set1(1.6666665459e-1f));
+    p = fmadd(p, r, set1(5.0000001201e-1f));
+    p = fmadd(p, mul(r, r), add(r, set1(1.0f)));
+    return mul(p, pow2n(n));
+}
+
+// ln(x) для нормализованных x > 0: x = m 2^e, m в [sqrt(1/2), sqrt(2)).
+// Абсолютная ошибка <= 1e-7 при m около 1, относительная - около 1 ulp.
+static inline V vlog(V x) {
+    V e;
+    V m = vfrexp(x, e);
+    const M small = lt(m, set1(0.707106781186547524f));
+    e = select(small, sub(e, set1(1.0f)), e);
+    m = sub(select(small, add(m, m), m), set1(1.0f));
+
+    const V z = mul(m, m);
+    V y = set1(7.0376836292e-2f);
+    y = fmadd(y, m, set1(-1.1514610310e-1f));
+    y = fmadd(y, m, set1(1.1676998740e-1f));
+    y = fmadd(y, m, set1(-1.2420140846e-1f));
+    y = fmadd(y, m, set1(1.4249322787e-1f));
+    y = fmadd(y, m, set1(-1.6668057665e-1f));
+    y = fmadd(y, m, set1(2.0000714765e-1f));
+    y = fmadd(y, m, set1(-2.4999993993e-1f));
+    y = fmadd(y, m, set1(3.3333331174e-1f));
+    y = mul(mul(y, m), z);
+    y = fmadd(e, set1(-2.12194440e-4f), y);
+    y = fnmadd(z, set1(0.5f), y);
+    return fmadd(e, set1(0.693359375f), add(m, y));
+}
+
+// pow(x, s) для x >= 0; x ниже FLT_MIN дает pow(0, s)
+static inline V vpow(V x, V s, V zeroPow) {
+    const M positive = gt(x, set1(1.17549435e-38f));
+    return select(positive, vexp(mul(s, vlog(x))), zeroPow);
+}
+
+static inline V dot3(V ax, V ay, V az, V bx, V by, V bz) {
+    return fmadd(ax, bx, fmadd(ay, by, mul(az, bz)));
+}
+
+// Нормирование как в LightingModel: нулевой вектор заменяется на (0, 1, 0)
+static inline void normalize3(V& x, V& y, V& z) {
+    const V len2 = dot3(x, y, z, x, y, z);
+    const M valid = gt(len2, set1(1e-20f));
+    const V inv = div(set1(1.0f), vsqrt(vmax(len2, set1(1e-20f))));
+    x = select(valid, mul(x, inv), set1(0.0f));
+    y = select(valid, mul(y, inv), set1(1.0f));
+    z = select(valid, mul(z, inv), set1(0.0f));
+}
+
+// Таблица BRDFTables в точке x из [0, 1]: два gather и линейная интерполяция
+static inline V lookup(const float* table, V x) {
+    const float size = static_cast<float>(BRDFTables::kSize);
+    const V scaled = mul(vmin(vmax(x, set1(0.0f)), set1(1.0f)), set1(size));
+    const I index = toIndex(vmin(scaled, set1(size - 1.0f)));
+    const V t = sub(scaled, indexToFloat(index));
+    const V a = gather(table, index);
+    return fmadd(t, sub(gather(table + 1, index), a), a);
+}
+
+// Ядро инстанцируется под модель и набор возможностей: ветвлений на выбор
+// модели в цикле нет, константы материала загружаются в регистры до цикла.
+// LUT: D, G, F и блик Блинна берутся из m.tables, exp и pow не вычисляются.
+template<class Model, bool VIEW_PER_SAMPLE, bool TWO_SIDED, bool LUT>
+static void shadeRange(const Material& m, const FrameConstants& f, const ShadingBatch& b,
+    size_t begin, size_t end) {
+    const V zero = set1(0.0f);
+    const V one = set1(1.0f);
+    const V lx = set1(f.lx), ly = set1(f.ly), lz = set1(f.lz);
+    const V intensity = set1(m.intensity);
+
+    const float* tableD = nullptr;
+    const float* tableVis = nullptr;
+    const float* tableF = nullptr;
+    const float* tableBlinn = nullptr;
+    if constexpr (LUT) {
+        tableD = m.tables->D.data();
+        tableVis = m.tables->vis.data();
+        tableF = m.tables->F.data();
+        tableBlinn = m.tables->blinn.data();
+    }
+
+    if constexpr (std::is_same_v<Model, brdf::Unlit>) {
+        for (size_t i = begin; i + W <= end; i += W) {
+            store(b.diffuse + i, intensity);
+            store(b.specular + i, zero);
+        }
+        return;
+    }
+
+    for (size_t i = begin; i + W <= end; i += W) {
+        V nx = load(b.normalX + i);
+        V ny = load(b.normalY + i);
+        V nz = load(b.normalZ + i);
+
+        V vx, vy, vz;
+        if constexpr (VIEW_PER_SAMPLE) {
+            vx = load(b.viewX + i);
+            vy = load(b.viewY + i);
+            vz = load(b.viewZ + i);
+            normalize3(vx, vy, vz);
+        }
+        else {
+            vx = set1(f.vx);
+            vy = set1(f.vy);
+            vz = set1(f.vz);
+        }
+
+        if constexpr (TWO_SIDED) {
+            const V side = select(lt(dot3(nx, ny, nz, vx, vy, vz), zero), set1(-1.0f), one);
+            nx = mul(nx, side);
+            ny = mul(ny, side);
+            nz = mul(nz, side);
+        }
+
+        const V NdotL = vmax(zero, dot3(nx, ny, nz, lx, ly, lz));
+        V diffuse = mul(NdotL, intensity);
+        V specular = zero;
+
+        if constexpr (Model::kHalfVector) {
+            // Полусуммарный вектор: при общем viewDir он посчитан заранее
+            V hx, hy, hz;
+            if constexpr (VIEW_PER_SAMPLE) {
+                hx = add(lx, vx);
+                hy = add(ly, vy);
+                hz = add(lz, vz);
+                normalize3(hx, hy, hz);
+            }
+            else {
+                hx = set1(f.hx);
+                hy = set1(f.hy);
+                hz = set1(f.hz);
+            }
+            const V NdotH = vmax(zero, dot3(nx, ny, nz, hx, hy, hz));
+
+            if constexpr (std::is_same_v<Model, brdf::BlinnPhong>) {
+                if constexpr (LUT) {
+                    specular = mul(lookup(tableBlinn, vsqrt(sub(one, NdotH))), set1(m.halfIntensity));
+                }
+                else {
+                    specular = mul(vpow(NdotH, set1(m.shininess), set1(m.zeroPow)), set1(m.halfIntensity));
+                }
+            }
+            else {
+                const V NdotV = vmax(zero, dot3(nx, ny, nz, vx, vy, vz));
+                V VdotH;
+                if constexpr (VIEW_PER_SAMPLE) VdotH = vmax(zero, dot3(vx, vy, vz, hx, hy, hz));
+                else VdotH = set1(f.VdotH);
+
+                V F, spec;
+                if constexpr (LUT) {
+                    // D * G / (4 N.V N.L) = D(N.H) * vis(N.V) * vis(N.L)
+                    F = lookup(tableF, VdotH);
+                    const V D = lookup(tableD, vsqrt(sub(one, NdotH)));
+                    const V visibility = mul(lookup(tableVis, NdotV), lookup(tableVis, NdotL));
+                    spec = mul(mul(D, visibility), F);
+                }
+                else {
+                    // Распределение Бекмана
+                    const V cos2 = mul(NdotH, NdotH);
+                    const V tan2 = div(sub(one, cos2), vmax(cos2, set1(1e-10f)));
+                    const V D = div(vexp(mul(tan2, set1(-m.invAlpha2))), mul(mul(cos2, cos2), set1(m.piAlpha2)));
+
+                    // Геометрическое ослабление
+                    const V NdotV2 = mul(NdotV, NdotV);
+                    const V NdotL2 = mul(NdotL, NdotL);
+                    const V tanV2 = div(sub(one, NdotV2), vmax(NdotV2, set1(1e-20f)));
+                    const V tanL2 = div(sub(one, NdotL2), vmax(NdotL2, set1(1e-20f)));
+                    const V alpha2 = set1(m.alpha2);
+                    const V GV = div(set1(2.0f), add(one, vsqrt(fmadd(alpha2, tanV2, one))));
+                    const V GL = div(set1(2.0f), add(one, vsqrt(fmadd(alpha2, tanL2, one))));
+
+                    // Шлик: (1 - VdotH)^5 без pow
+                    const V c = sub(one, VdotH);
+                    const V c2 = mul(c, c);
+                    F = fmadd(set1(m.oneMinusF0), mul(mul(c2, c2), c), set1(m.F0));
+
+                    const V denominator = mul(set1(4.0f), mul(NdotV, NdotL));
+                    spec = div(mul(mul(D, mul(GV, GL)), F), denominator);
+                }
+
+                // Скользящие углы - только диффузная часть, как в скалярной модели
+                const M grazing = mor(le(NdotV, set1(0.001f)), le(NdotL, set1(0.001f)));
+                diffuse = select(grazing, diffuse, mul(diffuse, sub(one, F)));
+                specular = select(grazing, zero, mul(spec, intensity));
+            }
+        }
+
+        store(b.diffuse + i, diffuse);
+        store(b.specular + i, specular);
+    }
+}
+
+template<class Model, bool LUT>
+static void shadeModel(const Material& m, const FrameConstants& f, const ShadingBatch& b,
+    size_t begin, size_t end) {
+    if (b.viewX != nullptr) {
+        if (f.twoSided) shadeRange<Model, true, true, LUT>(m, f, b, begin, end);
+        else shadeRange<Model, true, false, LUT>(m, f, b, begin, end);
+    }
+    else {
+        if (f.twoSided) shadeRange<Model, false, true, LUT>(m, f, b, begin, end);
+        else shadeRange<Model, false, false, LUT>(m, f, b, begin, end);
+    }
+}
+
+// Обрабатывает [begin, end), end - begin кратно W
+static void shade(const Material& m, const FrameConstants& f, const ShadingBatch& b,
+    size_t begin, size_t end) {
+    brdf::dispatch(m.model, [&](auto model) {
+        if (m.tables != nullptr) shadeModel<decltype(model), true>(m, f, b, begin, end);
+        else shadeModel<decltype(model), false>(m, f, b, begin, end);
+    });
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config_reader.h"
+#include "brdf.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -14,6 +15,7 @@ public:
         TORRANCE_SPARROW = 2
     };
 
+    //  :     
     Vector3 calculateColor(const Vector3& normal,
         const Vector3& lightDir,
         const Vector3& viewDir,
@@ -24,24 +26,11 @@ public:
         float roughness = 0.3f,
         float reflectance = 0.5f) const;
 
-private:
-    Vector3 lambert(const Vector3& normal,
-        const Vector3& lightDir,
-        const Vector3& surfaceColor,
-        float intensity) const;
-
-    Vector3 phongBlinn(const Vector3& normal,
-        const Vector3& lightDir,
-        const Vector3& viewDir,
-        const Vector3& surfaceColor,
-        float intensity,
-        float shininess) const;
-
-    Vector3 torranceSparrow(const Vector3& normal,
+    //    (Material::bind / fromConfig);  
+    // material.ambient   occlusion (HeightfieldLighting::ambientOcclusion)
+    Vector3 calculateColor(const Material& material,
+        const Vector3& normal,
         const Vector3& lightDir,
         const Vector3& viewDir,
-        const Vector3& surfaceColor,
-        float intensity,
-        float roughness,
-        float reflectance) const;
+        float occlusion = 1.0f) const;
 };
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "mapped_file.h"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::create(const std::string& filename, uint64_t size) {
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Ошибка: Не удалось создать файл " << filename << std::endl;
+        return false;
+    }
+    fileHandle = file;
+    opened = true;
+    writable = true;
+    length = size;
+
+    if (size == 0) return true;
+
+    // Место выделяется до отображения: при нехватке диска запись через
+    // отображение дала бы исключение доступа вместо ошибки
+    LARGE_INTEGER li;
+    li.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, li, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+        std::cerr << "Ошибка: Не удалось выделить место под файл " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(li.HighPart), li.LowPart, nullptr);
+    if (!mapping) {
+        std::cerr << "Ошибка: Не удалось отобразить файл в память " << filename << std::endl;
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    mapped = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (!mapped) {
+        std::cerr << "Ошибка: Не удалось отобразить файл в память " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openRead(const std::string& filename) {
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Ошибка: Не удалось открыть файл " << filename << std::endl;
+        return false;
+    }
+    fileHandle = file;
+    opened = true;
+    writable = false;
+
+    LARGE_INTEGER li;
+    if (!GetFileSizeEx(file, &li)) {
+        close();
+        return false;
+    }
+    length = static_cast<uint64_t>(li.QuadPart);
+    if (length == 0) return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    mapped = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::close() {
+    bool ok = true;
+    if (mapped) {
+        if (writable) ok = FlushViewOfFile(mapped, 0) != 0;
+        UnmapViewOfFile(mapped);
+        mapped = nullptr;
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        mappingHandle = nullptr;
+    }
+    if (fileHandle) {
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        fileHandle = nullptr;
+    }
+    opened = false;
+    length = 0;
+    return ok;
+}
+
+#else
+
+bool MappedFile::create(const std::string& filename, uint64_t size) {
+    close();
+
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Не удалось создать файл " << filename << std::endl;
+        return false;
+    }
+    opened = true;
+    writable = true;
+    length = size;
+
+    if (size == 0) return true;
+
+    // Место резервируется до отображения: при нехватке диска запись через
+    // отображение дала бы SIGBUS вместо ошибки
+#ifdef __APPLE__
+    int error = EOPNOTSUPP;
+#else
+    int error = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+#endif
+    if (error == EINVAL || error == EOPNOTSUPP) {
+        // Файловая система не умеет резервировать: только размер
+        error = ::ftruncate(fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+    }
+    if (error != 0) {
+        std::cerr << "Ошибка: Не удалось выделить место под файл " << filename
+            << ": " << std::strerror(error) << std::endl;
+        close();
+        return false;
+    }
+
+    void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        std::cerr << "Ошибка: Не удалось отобразить файл в память " << filename << std::endl;
+        close();
+        return false;
+    }
+    mapped = static_cast<char*>(ptr);
+    return true;
+}
+
+bool MappedFile::openRead(const std::string& filename) {
+    close();
+
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Не удалось открыть файл " << filename << std::endl;
+        return false;
+    }
+    opened = true;
+    writable = false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    length = static_cast<uint64_t>(st.st_size);
+    if (length == 0) return true;
+
+    void* ptr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+        std::cerr << "Ошибка: Не удалось отобразить файл в память " << filename << std::endl;
+        close();
+        return false;
+    }
+    mapped = static_cast<char*>(ptr);
+#ifdef MADV_SEQUENTIAL
+    ::madvise(ptr, length, MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+bool MappedFile::close() {
+    bool ok = true;
+    if (mapped) {
+        ok = ::munmap(mapped, length) == 0;
+        mapped = nullptr;
+    }
+    if (fd >= 0) {
+        ok = (::close(fd) == 0) && ok;
+        fd = -1;
+    }
+    opened = false;
+    length = 0;
+    return ok;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Файл, отображенный в память. При записи размер задается заранее (ftruncate /
+// CreateFileMapping), и потоки заполняют непересекающиеся диапазоны байт;
+// при чтении файл отображается только для чтения.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool create(const std::string& filename, uint64_t size);
+    bool openRead(const std::string& filename);
+    bool close();
+
+    char* data() { return mapped; }
+    const char* data() const { return mapped; }
+    uint64_t size() const { return length; }
+    bool isOpen() const { return opened; }
+
+private:
+    char* mapped = nullptr;
+    uint64_t length = 0;
+    bool opened = false;
+    bool writable = false;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Общее представление треугольной сетки в памяти (импорт, визуализация)
+struct Mesh {
+    std::vector<float> positions;   // x, y, z для каждой вершины
+    std::vector<float> normals;     // nx, ny, nz (пусто, если нормалей нет)
+    std::vector<uint32_t> indices;  // по три индекса на треугольник
+
+    size_t vertexCount() const { return positions.size() / 3; }
+    size_t triangleCount() const { return indices.size() / 3; }
+    bool hasNormals() const { return !normals.empty() && normals.size() == positions.size(); }
+
+    void clear() {
+        positions.clear();
+        normals.clear();
+        indices.clear();
+    }
+};
@@ -16,8 +16,14 @@ public:
     virtual std::string getFileExtension() const = 0;
 };
 
+//   -      (mesh_writer_core.h):
+//       
+
 class OBJExporter : public MeshExporter {
 public:
+    explicit OBJExporter(bool writeNormals = true, bool doublePrecision = false)
+        : writeNormals(writeNormals), doublePrecision(doublePrecision) {}
+
     bool exportMesh(const std::vector<std::vector<double>>& depthData,
         const std::string& filename,
         float scale = 1.0f) override;
@@ -26,48 +32,81 @@ public:
     std::string getFileExtension() const override { return "obj"; }
 
 private:
-    void writeHeader(std::ofstream& file);
-    void writeVertices(std::ofstream& file,
-        const std::vector<std::vector<double>>& depthData,
-        float scale);
-    void writeNormals(std::ofstream& file,
-        const std::vector<std::vector<double>>& depthData,
-        float scale);
-    void writeFaces(std::ofstream& file,
-        const std::vector<std::vector<double>>& depthData);
+    bool writeNormals;
+    bool doublePrecision;
 };
 
 class STLExporter : public MeshExporter {
 public:
+    explicit STLExporter(bool binary = false) : binary(binary) {}
+
     bool exportMesh(const std::vector<std::vector<double>>& depthData,
         const std::string& filename,
         float scale = 1.0f) override;
 
-    std::string getFormatName() const override { return "STL (ASCII)"; }
+    std::string getFormatName() const override { return binary ? "STL (binary)" : "STL (ASCII)"; }
     std::string getFileExtension() const override { return "stl"; }
 
 private:
-    struct Triangle {
-        float normal[3];
-        float v1[3];
-        float v2[3];
-        float v3[3];
-    };
-
-
-    void computeNormal(float& nx, float& ny, float& nz,
-        const float v1[3], const float v2[3], const float v3[3]);
+    bool binary;
 };
 
 class PLYExporter : public MeshExporter {
 public:
+    explicit PLYExporter(bool binary = false, bool writeNormals = false, bool doublePrecision = false)
+        : binary(binary), writeNormals(writeNormals), doublePrecision(doublePrecision) {}
+
     bool exportMesh(const std::vector<std::vector<double>>& depthData,
         const std::string& filename,
         float scale = 1.0f) override;
 
-    std::string getFormatName() const override { return "PLY (ASCII)"; }
+    std::string getFormatName() const override { return binary ? "PLY (binary)" : "PLY (ASCII)"; }
     std::string getFileExtension() const override { return "ply"; }
 
+    //   0..1    (,  ):
+    //   uchar red/green/blue   ( )
+    void setVertexShade(const std::vector<float>* shade) { vertexShade = shade; }
+
 private:
-    void writeHeader(std::ofstream& file, int vertexCount, int faceCount);
+    bool binary;
+    bool writeNormals;
+    bool doublePrecision;
+    const std::vector<float>* vertexShade = nullptr;
+};
+
+//    (   ,  )
+class PointCloudExporter : public MeshExporter {
+public:
+    enum Format {
+        BINARY_PLY = 0,
+        XYZ = 1,
+        XYZN = 2
+    };
+
+    explicit PointCloudExporter(Format format = BINARY_PLY,
+        int stride = 1,
+        float voxelSize = 0.0f);
+
+    bool exportMesh(const std::vector<std::vector<double>>& depthData,
+        const std::string& filename,
+        float scale = 1.0f) override;
+
+    std::string getFormatName() const override;
+    std::string getFileExtension() const override;
+
+private:
+    //    SoA,      
+    struct Samples {
+        std::vector<float> x, y, z;
+        std::vector<float> nx, ny, nz;
+    };
+
+    void collectSamples(const std::vector<std::vector<double>>& depthData,
+        float scale, Samples& samples) const;
+    bool writeBinaryPLY(const Samples& samples, const std::string& filename) const;
+    bool writeXYZ(const Samples& samples, const std::string& filename, bool withNormals) const;
+
+    Format format;
+    int stride;
+    float voxelSize;
 };
\ No newline at end of file
@@ -0,0 +1,946 @@
+#include "mesh_importer.h"
+#include "mapped_file.h"
+#include "parallel_utils.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MESH_IMPORTER_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Сканирование текста
+// ---------------------------------------------------------------------------
+
+static inline int lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static inline int bitCount(unsigned mask) {
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return static_cast<int>((((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Поиск '\n' по 16 байт за шаг (SSE2), хвост - через memchr
+static const char* findNewline(const char* p, const char* end) {
+#ifdef MESH_IMPORTER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        if (mask) return p + lowestBit(mask);
+        p += 16;
+    }
+#endif
+    const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+static size_t countNewlines(const char* p, const char* end) {
+    size_t count = 0;
+#ifdef MESH_IMPORTER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        count += bitCount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))));
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == '\n') ++count;
+    }
+    return count;
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+template<class T>
+static inline bool parseNumber(const char*& p, const char* end, T& value) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') ++p;
+    const auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static inline bool startsWithWord(const char* p, const char* end, const char* word) {
+    const size_t length = std::strlen(word);
+    if (static_cast<size_t>(end - p) < length || std::memcmp(p, word, length) != 0) return false;
+    return p + length == end || isBlank(p[length]) || p[length] == '\n';
+}
+
+static inline const char* nextLine(const char* lineEnd, const char* end) {
+    return lineEnd < end ? lineEnd + 1 : end;
+}
+
+struct TextChunk {
+    const char* begin;
+    const char* end;
+};
+
+// Делит текст на куски примерно равного размера по границам строк
+static std::vector<TextChunk> splitAtLines(const char* begin, const char* end) {
+    const size_t minChunk = 1 << 20;
+    const size_t size = static_cast<size_t>(end - begin);
+    const int parts = static_cast<int>(std::max<size_t>(1,
+        std::min<size_t>(static_cast<size_t>(workerCount()), size / minChunk)));
+
+    std::vector<TextChunk> chunks;
+    const char* start = begin;
+    for (int k = 1; k < parts; ++k) {
+        const char* cut = begin + size * k / parts;
+        if (cut <= start) continue;
+        cut = nextLine(findNewline(cut, end), end);
+        chunks.push_back({ start, cut });
+        start = cut;
+    }
+    if (start < end || chunks.empty()) {
+        chunks.push_back({ start, end });
+    }
+    return chunks;
+}
+
+template<class Fn>
+static void forEachChunk(size_t count, Fn&& fn) {
+    parallelFor(0, static_cast<int>(count), [&](int first, int last) {
+        for (int c = first; c < last; ++c) fn(static_cast<size_t>(c));
+    });
+}
+
+static std::string lowerExtension(const std::string& filename) {
+    const size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos) return std::string();
+    std::string ext = filename.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+// ---------------------------------------------------------------------------
+// Общий вход
+// ---------------------------------------------------------------------------
+
+bool MeshImporter::isSupported(const std::string& filename) {
+    const std::string ext = lowerExtension(filename);
+    return ext == "obj" || ext == "ply" || ext == "stl";
+}
+
+bool MeshImporter::importMesh(const std::string& filename, Mesh& mesh) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::string ext = lowerExtension(filename);
+
+    bool ok = false;
+    if (ext == "obj") ok = importOBJ(filename, mesh);
+    else if (ext == "ply") ok = importPLY(filename, mesh);
+    else if (ext == "stl") ok = importSTL(filename, mesh);
+    else {
+        std::cerr << "Ошибка: Неизвестный формат сетки " << filename << std::endl;
+        return false;
+    }
+
+    if (ok) {
+        const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "Загружено: " << filename << " (вершин: " << mesh.vertexCount()
+            << ", треугольников: " << mesh.triangleCount() << ", " << ms << " мс)" << std::endl;
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// OBJ
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct OBJChunk {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<int64_t> indices;      // 0-based; отрицательные ссылки - от начала куска
+    std::vector<size_t> relative;      // позиции в indices, требующие сдвига на начало куска
+    bool failed = false;
+};
+
+}
+
+static void parseOBJChunk(const TextChunk& chunk, OBJChunk& out) {
+    const char* p = chunk.begin;
+    const char* const end = chunk.end;
+
+    std::vector<int64_t> polygon;
+    std::vector<char> polygonRelative;
+
+    while (p < end && !out.failed) {
+        const char* lineEnd = findNewline(p, end);
+        const char* q = skipBlanks(p, lineEnd);
+
+        if (startsWithWord(q, lineEnd, "v")) {
+            q += 1;
+            float x, y, z;
+            if (!parseNumber(q, lineEnd, x) || !parseNumber(q, lineEnd, y) || !parseNumber(q, lineEnd, z)) {
+                out.failed = true;
+                break;
+            }
+            out.positions.push_back(x);
+            out.positions.push_back(y);
+            out.positions.push_back(z);
+        }
+        else if (startsWithWord(q, lineEnd, "vn")) {
+            q += 2;
+            float x, y, z;
+            if (!parseNumber(q, lineEnd, x) || !parseNumber(q, lineEnd, y) || !parseNumber(q, lineEnd, z)) {
+                out.failed = true;
+                break;
+            }
+            out.normals.push_back(x);
+            out.normals.push_back(y);
+            out.normals.push_back(z);
+        }
+        else if (startsWithWord(q, lineEnd, "f")) {
+            q += 1;
+            polygon.clear();
+            polygonRelative.clear();
+            const int64_t localVertices = static_cast<int64_t>(out.positions.size() / 3);
+
+            for (;;) {
+                q = skipBlanks(q, lineEnd);
+                if (q >= lineEnd) break;
+
+                int64_t index = 0;
+                const auto result = std::from_chars(q, lineEnd, index);
+                if (result.ec != std::errc() || index == 0) {
+                    out.failed = true;
+                    break;
+                }
+                // Пропускаем /vt/vn: нормали берутся по индексу вершины
+                q = result.ptr;
+                while (q < lineEnd && !isBlank(*q)) ++q;
+
+                if (index > 0) {
+                    polygon.push_back(index - 1);
+                    polygonRelative.push_back(0);
+                }
+                else {
+                    polygon.push_back(localVertices + index);
+                    polygonRelative.push_back(1);
+                }
+            }
+
+            // Многоугольник разбивается веером
+            for (size_t k = 1; k + 1 < polygon.size(); ++k) {
+                const size_t corners[3] = { 0, k, k + 1 };
+                for (size_t c : corners) {
+                    if (polygonRelative[c]) out.relative.push_back(out.indices.size());
+                    out.indices.push_back(polygon[c]);
+                }
+            }
+        }
+        // Остальные строки (комментарии, vt, g, o, s, usemtl) пропускаются
+
+        p = nextLine(lineEnd, end);
+    }
+}
+
+bool MeshImporter::importOBJ(const std::string& filename, Mesh& mesh) {
+    MappedFile file;
+    if (!file.openRead(filename)) return false;
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    const std::vector<TextChunk> chunks = splitAtLines(begin, end);
+    std::vector<OBJChunk> parsed(chunks.size());
+    forEachChunk(chunks.size(), [&](size_t c) { parseOBJChunk(chunks[c], parsed[c]); });
+
+    // Сдвиги кусков в общей нумерации
+    std::vector<size_t> vertexStart(chunks.size()), normalStart(chunks.size()), indexStart(chunks.size());
+    size_t totalVertices = 0, totalNormals = 0, totalIndices = 0;
+    for (size_t c = 0; c < parsed.size(); ++c) {
+        if (parsed[c].failed) {
+            std::cerr << "Ошибка: Некорректная строка в OBJ файле " << filename << std::endl;
+            return false;
+        }
+        vertexStart[c] = totalVertices;
+        normalStart[c] = totalNormals;
+        indexStart[c] = totalIndices;
+        totalVertices += parsed[c].positions.size() / 3;
+        totalNormals += parsed[c].normals.size() / 3;
+        totalIndices += parsed[c].indices.size();
+    }
+
+    mesh.clear();
+    mesh.positions.resize(totalVertices * 3);
+    // Нормали сопоставляются вершинам, только если их столько же (f v//v)
+    const bool keepNormals = totalNormals == totalVertices && totalNormals > 0;
+    if (keepNormals) mesh.normals.resize(totalNormals * 3);
+    mesh.indices.resize(totalIndices);
+
+    std::atomic<bool> badIndex(false);
+    forEachChunk(parsed.size(), [&](size_t c) {
+        OBJChunk& chunk = parsed[c];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + vertexStart[c] * 3);
+        if (keepNormals) {
+            std::copy(chunk.normals.begin(), chunk.normals.end(), mesh.normals.begin() + normalStart[c] * 3);
+        }
+
+        for (size_t position : chunk.relative) {
+            chunk.indices[position] += static_cast<int64_t>(vertexStart[c]);
+        }
+
+        uint32_t* out = mesh.indices.data() + indexStart[c];
+        for (size_t k = 0; k < chunk.indices.size(); ++k) {
+            const int64_t index = chunk.indices[k];
+            if (index < 0 || index >= static_cast<int64_t>(totalVertices)) {
+                badIndex = true;
+                return;
+            }
+            out[k] = static_cast<uint32_t>(index);
+        }
+    });
+
+    if (badIndex) {
+        std::cerr << "Ошибка: Индекс вершины вне диапазона в " << filename << std::endl;
+        mesh.clear();
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// PLY
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum PlyType {
+    PLY_INVALID = 0,
+    PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+    PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PLY_INVALID;
+    bool isList = false;
+    PlyType countType = PLY_INVALID;
+};
+
+struct PlyElement {
+    std::string name;
+    uint64_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+struct PlyHeader {
+    bool binary = false;
+    std::vector<PlyElement> elements;
+    const char* body = nullptr;
+};
+
+}
+
+static PlyType plyTypeFromName(const std::string& name) {
+    if (name == "char" || name == "int8") return PLY_INT8;
+    if (name == "uchar" || name == "uint8") return PLY_UINT8;
+    if (name == "short" || name == "int16") return PLY_INT16;
+    if (name == "ushort" || name == "uint16") return PLY_UINT16;
+    if (name == "int" || name == "int32") return PLY_INT32;
+    if (name == "uint" || name == "uint32") return PLY_UINT32;
+    if (name == "float" || name == "float32") return PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PLY_FLOAT64;
+    return PLY_INVALID;
+}
+
+static size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PLY_INT8: case PLY_UINT8: return 1;
+    case PLY_INT16: case PLY_UINT16: return 2;
+    case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+    case PLY_FLOAT64: return 8;
+    default: return 0;
+    }
+}
+
+template<class T>
+static inline T loadUnaligned(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+static inline double readPlyScalar(PlyType type, const char* p) {
+    switch (type) {
+    case PLY_INT8: return loadUnaligned<int8_t>(p);
+    case PLY_UINT8: return loadUnaligned<uint8_t>(p);
+    case PLY_INT16: return loadUnaligned<int16_t>(p);
+    case PLY_UINT16: return loadUnaligned<uint16_t>(p);
+    case PLY_INT32: return loadUnaligned<int32_t>(p);
+    case PLY_UINT32: return loadUnaligned<uint32_t>(p);
+    case PLY_FLOAT32: return loadUnaligned<float>(p);
+    case PLY_FLOAT64: return loadUnaligned<double>(p);
+    default: return 0.0;
+    }
+}
+
+static inline int64_t readPlyIndex(PlyType type, const char* p) {
+    switch (type) {
+    case PLY_INT8: return loadUnaligned<int8_t>(p);
+    case PLY_UINT8: return loadUnaligned<uint8_t>(p);
+    case PLY_INT16: return loadUnaligned<int16_t>(p);
+    case PLY_UINT16: return loadUnaligned<uint16_t>(p);
+    case PLY_INT32: return loadUnaligned<int32_t>(p);
+    case PLY_UINT32: return loadUnaligned<uint32_t>(p);
+    default: return -1;
+    }
+}
+
+static bool parsePlyHeader(const char* begin, const char* end, PlyHeader& header) {
+    const char* p = begin;
+    bool sawMagic = false;
+    bool sawFormat = false;
+
+    while (p < end) {
+        const char* lineEnd = findNewline(p, end);
+        std::string line(p, lineEnd);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        p = nextLine(lineEnd, end);
+
+        std::istringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+
+        if (!sawMagic) {
+            if (keyword != "ply") return false;
+            sawMagic = true;
+        }
+        else if (keyword == "format") {
+            std::string format;
+            ss >> format;
+            if (format == "ascii") header.binary = false;
+            else if (format == "binary_little_endian") header.binary = true;
+            else {
+                std::cerr << "Ошибка: Неподдерживаемый формат PLY: " << format << std::endl;
+                return false;
+            }
+            sawFormat = true;
+        }
+        else if (keyword == "element") {
+            PlyElement element;
+            ss >> element.name >> element.count;
+            header.elements.push_back(element);
+        }
+        else if (keyword == "property") {
+            if (header.elements.empty()) return false;
+            PlyProperty property;
+            std::string type;
+            ss >> type;
+            if (type == "list") {
+                std::string countType, itemType;
+                ss >> countType >> itemType >> property.name;
+                property.isList = true;
+                property.countType = plyTypeFromName(countType);
+                property.type = plyTypeFromName(itemType);
+                if (property.countType == PLY_INVALID) return false;
+            }
+            else {
+                ss >> property.name;
+                property.type = plyTypeFromName(type);
+            }
+            if (property.type == PLY_INVALID) return false;
+            header.elements.back().properties.push_back(property);
+        }
+        else if (keyword == "end_header") {
+            header.body = p;
+            return sawFormat;
+        }
+        // comment, obj_info и пустые строки пропускаются
+    }
+    return false;
+}
+
+// Индексы x, y, z, nx, ny, nz среди свойств вершины (-1, если нет)
+static void findVertexProperties(const PlyElement& vertex, int slots[6]) {
+    static const char* names[6] = { "x", "y", "z", "nx", "ny", "nz" };
+    for (int s = 0; s < 6; ++s) {
+        slots[s] = -1;
+        for (size_t k = 0; k < vertex.properties.size(); ++k) {
+            if (!vertex.properties[k].isList && vertex.properties[k].name == names[s]) {
+                slots[s] = static_cast<int>(k);
+            }
+        }
+    }
+}
+
+static int findFaceList(const PlyElement& face) {
+    for (size_t k = 0; k < face.properties.size(); ++k) {
+        const PlyProperty& property = face.properties[k];
+        if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+            return static_cast<int>(k);
+        }
+    }
+    return -1;
+}
+
+static size_t fixedRecordSize(const PlyElement& element) {
+    size_t size = 0;
+    for (const auto& property : element.properties) {
+        if (property.isList) return 0;
+        size += plyTypeSize(property.type);
+    }
+    return size;
+}
+
+static bool appendFan(const int64_t* polygon, size_t count, uint64_t vertexCount,
+    std::vector<uint32_t>& triangles) {
+    for (size_t k = 0; k < count; ++k) {
+        if (polygon[k] < 0 || static_cast<uint64_t>(polygon[k]) >= vertexCount) return false;
+    }
+    for (size_t k = 1; k + 1 < count; ++k) {
+        triangles.push_back(static_cast<uint32_t>(polygon[0]));
+        triangles.push_back(static_cast<uint32_t>(polygon[k]));
+        triangles.push_back(static_cast<uint32_t>(polygon[k + 1]));
+    }
+    return true;
+}
+
+static bool importPLYAscii(const PlyHeader& header, const char* end, Mesh& mesh,
+    int vertexElement, int faceElement) {
+    // Каждый элемент занимает одну строку; диапазоны строк по элементам
+    std::vector<uint64_t> firstLine(header.elements.size() + 1, 0);
+    for (size_t e = 0; e < header.elements.size(); ++e) {
+        firstLine[e + 1] = firstLine[e] + header.elements[e].count;
+    }
+
+    const std::vector<TextChunk> chunks = splitAtLines(header.body, end);
+
+    // Номер первой строки каждого куска: параллельный подсчет переводов строк
+    std::vector<uint64_t> chunkLine(chunks.size() + 1, 0);
+    std::vector<uint64_t> chunkLines(chunks.size(), 0);
+    forEachChunk(chunks.size(), [&](size_t c) {
+        chunkLines[c] = countNewlines(chunks[c].begin, chunks[c].end);
+    });
+    for (size_t c = 0; c < chunks.size(); ++c) chunkLine[c + 1] = chunkLine[c] + chunkLines[c];
+
+    const PlyElement& vertex = header.elements[vertexElement];
+    int slots[6];
+    findVertexProperties(vertex, slots);
+    const bool withNormals = slots[3] >= 0 && slots[4] >= 0 && slots[5] >= 0;
+    const uint64_t vertexCount = vertex.count;
+
+    mesh.clear();
+    mesh.positions.resize(vertexCount * 3);
+    if (withNormals) mesh.normals.resize(vertexCount * 3);
+
+    std::vector<std::vector<uint32_t>> triangles(chunks.size());
+    std::atomic<bool> failed(false);
+
+    forEachChunk(chunks.size(), [&](size_t c) {
+        const char* p = chunks[c].begin;
+        const char* const chunkEnd = chunks[c].end;
+        uint64_t line = chunkLine[c];
+        std::vector<double> values(vertex.properties.size());
+        std::vector<int64_t> polygon;
+
+        while (p < chunkEnd && !failed) {
+            const char* lineEnd = findNewline(p, chunkEnd);
+            const char* q = p;
+
+            if (line >= firstLine[vertexElement] && line < firstLine[vertexElement + 1]) {
+                for (double& value : values) {
+                    if (!parseNumber(q, lineEnd, value)) {
+                        failed = true;
+                        return;
+                    }
+                }
+                const uint64_t v = line - firstLine[vertexElement];
+                for (int s = 0; s < 3; ++s) {
+                    mesh.positions[v * 3 + s] = slots[s] >= 0 ? static_cast<float>(values[slots[s]]) : 0.0f;
+                    if (withNormals) mesh.normals[v * 3 + s] = static_cast<float>(values[slots[s + 3]]);
+                }
+            }
+            else if (faceElement >= 0 && line >= firstLine[faceElement] && line < firstLine[faceElement + 1]) {
+                // Для граней поддерживается единственное свойство - список индексов
+                int64_t count = 0;
+                if (!parseNumber(q, lineEnd, count) || count < 0) {
+                    failed = true;
+                    return;
+                }
+                polygon.resize(static_cast<size_t>(count));
+                for (int64_t& index : polygon) {
+                    if (!parseNumber(q, lineEnd, index)) {
+                        failed = true;
+                        return;
+                    }
+                }
+                if (!appendFan(polygon.data(), polygon.size(), vertexCount, triangles[c])) {
+                    failed = true;
+                    return;
+                }
+            }
+
+            p = nextLine(lineEnd, chunkEnd);
+            ++line;
+        }
+    });
+
+    if (failed) return false;
+
+    size_t total = 0;
+    for (const auto& t : triangles) total += t.size();
+    mesh.indices.reserve(total);
+    for (const auto& t : triangles) mesh.indices.insert(mesh.indices.end(), t.begin(), t.end());
+    return true;
+}
+
+static bool importPLYBinary(const PlyHeader& header, const char* end, Mesh& mesh,
+    int vertexElement, int faceElement) {
+    const char* p = header.body;
+    mesh.clear();
+
+    for (size_t e = 0; e < header.elements.size(); ++e) {
+        const PlyElement& element = header.elements[e];
+        const size_t recordSize = fixedRecordSize(element);
+
+        // Вершины и грани делятся между потоками по диапазонам int
+        if ((static_cast<int>(e) == vertexElement || static_cast<int>(e) == faceElement)
+            && element.count > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            std::cerr << "Ошибка: Слишком много записей в элементе PLY " << element.name
+                << ": " << element.count << std::endl;
+            return false;
+        }
+
+        if (static_cast<int>(e) == vertexElement) {
+            if (recordSize == 0 || static_cast<uint64_t>(end - p) < element.count * recordSize) return false;
+
+            int slots[6];
+            findVertexProperties(element, slots);
+            size_t offsets[6] = {};
+            PlyType types[6] = {};
+            for (int s = 0; s < 6; ++s) {
+                if (slots[s] < 0) continue;
+                for (int k = 0; k < slots[s]; ++k) offsets[s] += plyTypeSize(element.properties[k].type);
+                types[s] = element.properties[slots[s]].type;
+            }
+            const bool withNormals = slots[3] >= 0 && slots[4] >= 0 && slots[5] >= 0;
+
+            mesh.positions.resize(element.count * 3);
+            if (withNormals) mesh.normals.resize(element.count * 3);
+
+            // Записи фиксированного размера: каждый поток читает свой диапазон
+            const char* base = p;
+            parallelFor(0, static_cast<int>(element.count), [&](int first, int last) {
+                for (int v = first; v < last; ++v) {
+                    const char* record = base + static_cast<size_t>(v) * recordSize;
+                    for (int s = 0; s < 3; ++s) {
+                        mesh.positions[static_cast<size_t>(v) * 3 + s] = slots[s] >= 0
+                            ? static_cast<float>(readPlyScalar(types[s], record + offsets[s])) : 0.0f;
+                        if (withNormals) {
+                            mesh.normals[static_cast<size_t>(v) * 3 + s] =
+                                static_cast<float>(readPlyScalar(types[s + 3], record + offsets[s + 3]));
+                        }
+                    }
+                }
+            }, 4096);
+            p += element.count * recordSize;
+        }
+        else if (static_cast<int>(e) == faceElement) {
+            const int listIndex = findFaceList(element);
+            const uint64_t vertexCount = mesh.vertexCount();
+
+            // Быстрый путь: единственное свойство-список и только треугольники,
+            // тогда записи имеют фиксированный размер и читаются параллельно
+            if (element.properties.size() == 1) {
+                const PlyProperty& list = element.properties[0];
+                const size_t countSize = plyTypeSize(list.countType);
+                const size_t itemSize = plyTypeSize(list.type);
+                const size_t triangleRecord = countSize + 3 * itemSize;
+
+                if (static_cast<uint64_t>(end - p) >= element.count * triangleRecord) {
+                    mesh.indices.resize(element.count * 3);
+                    std::atomic<bool> mismatch(false);
+                    const char* base = p;
+                    parallelFor(0, static_cast<int>(element.count), [&](int first, int last) {
+                        for (int f = first; f < last && !mismatch; ++f) {
+                            const char* record = base + static_cast<size_t>(f) * triangleRecord;
+                            if (readPlyIndex(list.countType, record) != 3) {
+                                mismatch = true;
+                                return;
+                            }
+                            for (int k = 0; k < 3; ++k) {
+                                const int64_t index = readPlyIndex(list.type, record + countSize + k * itemSize);
+                                if (index < 0 || static_cast<uint64_t>(index) >= vertexCount) {
+                                    mismatch = true;
+                                    return;
+                                }
+                                mesh.indices[static_cast<size_t>(f) * 3 + k] = static_cast<uint32_t>(index);
+                            }
+                        }
+                    }, 4096);
+
+                    if (!mismatch) {
+                        p += element.count * triangleRecord;
+                        continue;
+                    }
+                    mesh.indices.clear();
+                }
+            }
+
+            // Общий случай: последовательный разбор записей переменной длины
+            std::vector<int64_t> polygon;
+            for (uint64_t f = 0; f < element.count; ++f) {
+                for (size_t k = 0; k < element.properties.size(); ++k) {
+                    const PlyProperty& property = element.properties[k];
+                    if (!property.isList) {
+                        p += plyTypeSize(property.type);
+                        continue;
+                    }
+                    const size_t countSize = plyTypeSize(property.countType);
+                    const size_t itemSize = plyTypeSize(property.type);
+                    if (static_cast<size_t>(end - p) < countSize) return false;
+                    const int64_t count = readPlyIndex(property.countType, p);
+                    p += countSize;
+                    if (count < 0 || static_cast<uint64_t>(end - p) < static_cast<uint64_t>(count) * itemSize) return false;
+
+                    if (static_cast<int>(k) == listIndex) {
+                        polygon.resize(static_cast<size_t>(count));
+                        for (int64_t i = 0; i < count; ++i) {
+                            polygon[i] = readPlyIndex(property.type, p + i * itemSize);
+                        }
+                        if (!appendFan(polygon.data(), polygon.size(), vertexCount, mesh.indices)) return false;
+                    }
+                    p += count * itemSize;
+                }
+            }
+        }
+        else {
+            // Прочие элементы пропускаются (только фиксированного размера)
+            if (recordSize == 0) {
+                if (static_cast<int>(e) < std::max(vertexElement, faceElement)) {
+                    std::cerr << "Ошибка: Элемент PLY " << element.name
+                        << " переменной длины перед вершинами или гранями не поддерживается" << std::endl;
+                    return false;
+                }
+                break;
+            }
+            p += element.count * recordSize;
+        }
+
+        if (p > end) return false;
+    }
+    return true;
+}
+
+bool MeshImporter::importPLY(const std::string& filename, Mesh& mesh) {
+    MappedFile file;
+    if (!file.openRead(filename)) return false;
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    PlyHeader header;
+    if (!parsePlyHeader(begin, end, header)) {
+        std::cerr << "Ошибка: Некорректный заголовок PLY в " << filename << std::endl;
+        return false;
+    }
+
+    int vertexElement = -1, faceElement = -1;
+    for (size_t e = 0; e < header.elements.size(); ++e) {
+        if (header.elements[e].name == "vertex") vertexElement = static_cast<int>(e);
+        else if (header.elements[e].name == "face" && findFaceList(header.elements[e]) >= 0) {
+            faceElement = static_cast<int>(e);
+        }
+    }
+    if (vertexElement < 0) {
+        std::cerr << "Ошибка: В PLY нет элемента vertex: " << filename << std::endl;
+        return false;
+    }
+    if (faceElement >= 0 && faceElement < vertexElement) {
+        std::cerr << "Ошибка: Грани PLY идут раньше вершин: " << filename << std::endl;
+        return false;
+    }
+
+    const bool ok = header.binary
+        ? importPLYBinary(header, end, mesh, vertexElement, faceElement)
+        : importPLYAscii(header, end, mesh, vertexElement, faceElement);
+
+    if (!ok) {
+        std::cerr << "Ошибка: Некорректные данные PLY в " << filename << std::endl;
+        mesh.clear();
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// STL
+// ---------------------------------------------------------------------------
+
+// Вершины STL не общие: на каждый треугольник три вершины с нормалью грани
+static bool importSTLBinary(const char* begin, uint32_t triangleCount, Mesh& mesh) {
+    mesh.clear();
+    mesh.positions.resize(static_cast<size_t>(triangleCount) * 9);
+    mesh.normals.resize(static_cast<size_t>(triangleCount) * 9);
+    mesh.indices.resize(static_cast<size_t>(triangleCount) * 3);
+
+    const char* base = begin + 84;
+    parallelFor(0, static_cast<int>(triangleCount), [&](int first, int last) {
+        for (int t = first; t < last; ++t) {
+            const char* record = base + static_cast<size_t>(t) * 50;
+            float values[12];
+            std::memcpy(values, record, sizeof(values));
+
+            float* position = &mesh.positions[static_cast<size_t>(t) * 9];
+            float* normal = &mesh.normals[static_cast<size_t>(t) * 9];
+            for (int k = 0; k < 3; ++k) {
+                position[k * 3 + 0] = values[3 + k * 3 + 0];
+                position[k * 3 + 1] = values[3 + k * 3 + 1];
+                position[k * 3 + 2] = values[3 + k * 3 + 2];
+                normal[k * 3 + 0] = values[0];
+                normal[k * 3 + 1] = values[1];
+                normal[k * 3 + 2] = values[2];
+                mesh.indices[static_cast<size_t>(t) * 3 + k] = static_cast<uint32_t>(t * 3 + k);
+            }
+        }
+    }, 4096);
+    return true;
+}
+
+namespace {
+
+struct STLChunk {
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    bool failed = false;
+};
+
+}
+
+static bool importSTLAscii(const char* begin, const char* end, Mesh& mesh) {
+    const std::vector<TextChunk> chunks = splitAtLines(begin, end);
+    std::vector<STLChunk> parsed(chunks.size());
+
+    forEachChunk(chunks.size(), [&](size_t c) {
+        STLChunk& out = parsed[c];
+        const char* p = chunks[c].begin;
+        const char* const chunkEnd = chunks[c].end;
+
+        while (p < chunkEnd) {
+            const char* lineEnd = findNewline(p, chunkEnd);
+            const char* q = skipBlanks(p, lineEnd);
+
+            float x, y, z;
+            if (startsWithWord(q, lineEnd, "vertex")) {
+                q += 6;
+                if (!parseNumber(q, lineEnd, x) || !parseNumber(q, lineEnd, y) || !parseNumber(q, lineEnd, z)) {
+                    out.failed = true;
+                    return;
+                }
+                out.vertices.push_back(x);
+                out.vertices.push_back(y);
+                out.vertices.push_back(z);
+            }
+            else if (startsWithWord(q, lineEnd, "facet")) {
+                q = skipBlanks(q + 5, lineEnd);
+                if (startsWithWord(q, lineEnd, "normal")) {
+                    q += 6;
+                    if (!parseNumber(q, lineEnd, x) || !parseNumber(q, lineEnd, y) || !parseNumber(q, lineEnd, z)) {
+                        out.failed = true;
+                        return;
+                    }
+                    out.normals.push_back(x);
+                    out.normals.push_back(y);
+                    out.normals.push_back(z);
+                }
+            }
+            p = nextLine(lineEnd, chunkEnd);
+        }
+    });
+
+    size_t totalVertices = 0, totalFacets = 0;
+    for (const auto& chunk : parsed) {
+        if (chunk.failed) return false;
+        totalVertices += chunk.vertices.size() / 3;
+        totalFacets += chunk.normals.size() / 3;
+    }
+    if (totalVertices % 3 != 0) return false;
+
+    mesh.clear();
+    mesh.positions.reserve(totalVertices * 3);
+    for (const auto& chunk : parsed) {
+        mesh.positions.insert(mesh.positions.end(), chunk.vertices.begin(), chunk.vertices.end());
+    }
+
+    // Нормаль грани дублируется на три ее вершины
+    if (totalFacets * 3 == totalVertices) {
+        mesh.normals.reserve(totalVertices * 3);
+        for (const auto& chunk : parsed) {
+            for (size_t f = 0; f + 2 < chunk.normals.size(); f += 3) {
+                for (int k = 0; k < 3; ++k) {
+                    mesh.normals.push_back(chunk.normals[f]);
+                    mesh.normals.push_back(chunk.normals[f + 1]);
+                    mesh.normals.push_back(chunk.normals[f + 2]);
+                }
+            }
+        }
+    }
+
+    mesh.indices.resize(totalVertices);
+    for (size_t k = 0; k < totalVertices; ++k) {
+        mesh.indices[k] = static_cast<uint32_t>(k);
+    }
+    return true;
+}
+
+bool MeshImporter::importSTL(const std::string& filename, Mesh& mesh) {
+    MappedFile file;
+    if (!file.openRead(filename)) return false;
+
+    const char* begin = file.data();
+    const uint64_t size = file.size();
+
+    // Двоичный STL узнается по точному размеру: многие двоичные файлы
+    // тоже начинаются со слова "solid"
+    if (size >= 84) {
+        const uint32_t triangleCount = loadUnaligned<uint32_t>(begin + 80);
+        if (84 + static_cast<uint64_t>(triangleCount) * 50 == size) {
+            return importSTLBinary(begin, triangleCount, mesh);
+        }
+    }
+
+    if (size >= 5 && std::memcmp(begin, "solid", 5) == 0) {
+        if (importSTLAscii(begin, begin + size, mesh)) return true;
+    }
+
+    std::cerr << "Ошибка: Некорректный STL файл " << filename << std::endl;
+    mesh.clear();
+    return false;
+}
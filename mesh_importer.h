@@ -0,0 +1,19 @@
+#pragma once
+
+#include "mesh.h"
+#include <string>
+
+// Загрузка OBJ, PLY (ASCII и binary_little_endian) и STL (ASCII и binary).
+// Файл отображается в память, большие файлы разбираются параллельно
+// кусками, выровненными по границам строк (или записей для двоичных форматов).
+class MeshImporter {
+public:
+    // Формат определяется по расширению
+    static bool importMesh(const std::string& filename, Mesh& mesh);
+
+    static bool importOBJ(const std::string& filename, Mesh& mesh);
+    static bool importPLY(const std::string& filename, Mesh& mesh);
+    static bool importSTL(const std::string& filename, Mesh& mesh);
+
+    static bool isSupported(const std::string& filename);
+};
@@ -0,0 +1,562 @@
+#pragma once
+
+// Ядро сериализации сеток, специализированное на этапе компиляции.
+// Формат (OBJ/PLY/STL) и опции (ASCII/binary, float/double, нормали)
+// задаются параметрами шаблона, поэтому цикл по вершинам и граням
+// не содержит ни виртуальных вызовов, ни ветвлений по формату.
+// Виртуальный MeshExporter остается только тонкой оболочкой для main.
+
+#include "output_sink.h"
+#include "mapped_file.h"
+#include "parallel_utils.h"
+#include <vector>
+#include <string>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+
+// Буфер, который сбрасывается в приемник крупными блоками
+class MeshBlockWriter {
+public:
+    explicit MeshBlockWriter(OutputSink& sink, size_t blockSize = 1 << 20)
+        : sink(sink), buffer(blockSize) {
+        cur = buffer.data();
+        limit = buffer.data() + buffer.size();
+    }
+
+    // Гарантирует, что в буфере есть место под bytes байт
+    char* reserve(size_t bytes) {
+        if (static_cast<size_t>(limit - cur) < bytes) {
+            flush();
+            if (buffer.size() < bytes) {
+                buffer.resize(bytes);
+                cur = buffer.data();
+                limit = buffer.data() + buffer.size();
+            }
+        }
+        return cur;
+    }
+
+    void commit(char* end) { cur = end; }
+
+    void write(const std::string& text) {
+        char* out = reserve(text.size());
+        std::memcpy(out, text.data(), text.size());
+        commit(out + text.size());
+    }
+
+    void flush() {
+        if (cur != buffer.data() && !sink.write(buffer.data(), cur - buffer.data())) {
+            failed = true;
+        }
+        cur = buffer.data();
+    }
+
+    bool finish() {
+        flush();
+        return !failed;
+    }
+
+private:
+    OutputSink& sink;
+    bool failed = false;
+    std::vector<char> buffer;
+    char* cur;
+    char* limit;
+};
+
+// Запись чисел: ASCII через to_chars или сырые байты
+template<class Real, bool Binary>
+struct MeshNumber;
+
+template<class Real>
+struct MeshNumber<Real, false> {
+    static constexpr size_t kMaxBytes = 32;
+
+    static char* put(char* out, double value) {
+        if constexpr (std::is_same_v<Real, float>) {
+            // Как std::ostream по умолчанию (%g, 6 значащих цифр)
+            return std::to_chars(out, out + kMaxBytes, static_cast<float>(value),
+                std::chars_format::general, 6).ptr;
+        }
+        else {
+            return std::to_chars(out, out + kMaxBytes, value).ptr;
+        }
+    }
+
+    static char* putIndex(char* out, int32_t value) {
+        return std::to_chars(out, out + kMaxBytes, value).ptr;
+    }
+};
+
+template<class Real>
+struct MeshNumber<Real, true> {
+    static constexpr size_t kMaxBytes = sizeof(Real);
+
+    static char* put(char* out, double value) {
+        const Real v = static_cast<Real>(value);
+        std::memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+
+    static char* putIndex(char* out, int32_t value) {
+        std::memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+};
+
+template<size_t N>
+inline char* putText(char* out, const char (&text)[N]) {
+    std::memcpy(out, text, N - 1);
+    return out + N - 1;
+}
+
+// Нормаль поверхности высот по градиенту глубины: центральная разность,
+// у края или рядом с фоном - односторонняя
+inline void heightfieldNormal(const std::vector<std::vector<double>>& depthData,
+    int i, int j, double& nx, double& ny, double& nz) {
+    const int height = static_cast<int>(depthData.size());
+    const int width = static_cast<int>(depthData[0].size());
+    const double* row = depthData[i].data();
+    const double depth = row[j];
+
+    const bool hasLeft = j > 0 && row[j - 1] > 0.0;
+    const bool hasRight = j < width - 1 && row[j + 1] > 0.0;
+    const bool hasUp = i > 0 && depthData[i - 1][j] > 0.0;
+    const bool hasDown = i < height - 1 && depthData[i + 1][j] > 0.0;
+
+    double gx = 0.0, gz = 0.0;
+    if (hasLeft && hasRight) gx = (row[j + 1] - row[j - 1]) * 0.5;
+    else if (hasRight) gx = row[j + 1] - depth;
+    else if (hasLeft) gx = depth - row[j - 1];
+
+    if (hasUp && hasDown) gz = (depthData[i + 1][j] - depthData[i - 1][j]) * 0.5;
+    else if (hasDown) gz = depthData[i + 1][j] - depth;
+    else if (hasUp) gz = depth - depthData[i - 1][j];
+
+    const double invLen = 1.0 / std::sqrt(gx * gx + 1.0 + gz * gz);
+    nx = -gx * invLen;
+    ny = invLen;
+    nz = -gz * invLen;
+}
+
+// Сетка карты глубины: сквозная нумерация валидных вершин и число граней
+struct HeightfieldGrid {
+    const std::vector<std::vector<double>>& depthData;
+    int width;
+    int height;
+    double scale;
+    std::vector<int32_t> index;   // номер вершины или -1 для фона
+    std::vector<int64_t> rowFaceStart; // номер первого треугольника строки квадов
+    int64_t vertexCount = 0;
+    int64_t faceCount = 0;        // треугольники
+
+    HeightfieldGrid(const std::vector<std::vector<double>>& data, double scale)
+        : depthData(data),
+        width(static_cast<int>(data[0].size())),
+        height(static_cast<int>(data.size())),
+        scale(scale),
+        index(static_cast<size_t>(width) * height, -1),
+        rowFaceStart(height, 0) {
+        int32_t next = 0;
+        for (int i = 0; i < height; i++) {
+            const double* row = depthData[i].data();
+            for (int j = 0; j < width; j++) {
+                if (row[j] > 0.0) {
+                    index[static_cast<size_t>(i) * width + j] = next++;
+                }
+            }
+        }
+        vertexCount = next;
+
+        for (int i = 0; i < height - 1; i++) {
+            rowFaceStart[i] = faceCount;
+            const int32_t* top = &index[static_cast<size_t>(i) * width];
+            const int32_t* bottom = top + width;
+            for (int j = 0; j < width - 1; j++) {
+                if ((top[j] | top[j + 1] | bottom[j] | bottom[j + 1]) >= 0) {
+                    faceCount += 2;
+                }
+            }
+        }
+        if (height > 0) rowFaceStart[height - 1] = faceCount;
+    }
+
+    void position(int i, int j, double p[3]) const {
+        p[0] = (j - width / 2.0) * scale;
+        p[1] = depthData[i][j] * scale;
+        p[2] = (i - height / 2.0) * scale;
+    }
+};
+
+// Вершина треугольника, передаваемая в политику формата
+struct MeshCorner {
+    double p[3];
+    int32_t index;
+};
+
+// ---------------------------------------------------------------------------
+// Политики форматов. Единая сигнатура <Real, Binary, Normals>; параметры,
+// не имеющие смысла для формата, им игнорируются.
+// ---------------------------------------------------------------------------
+
+template<class Real, bool Binary, bool Normals>
+struct OBJFormat {
+    using Num = MeshNumber<Real, false>;
+    static constexpr bool kHasVertexList = true;
+    static constexpr bool kFixedRecords = false;
+    static constexpr size_t kVertexBytes = 6 * Num::kMaxBytes + 16;
+    static constexpr size_t kFaceBytes = 6 * Num::kMaxBytes + 16;
+
+    static std::string header(const HeightfieldGrid& grid) {
+        return "# 3D Model from Depth Map\n"
+            "# Generated by Lab4 - 3D Scene Modeling\n"
+            "# Format: Wavefront OBJ\n"
+            "# Vertices: " + std::to_string(grid.vertexCount) +
+            ", faces: " + std::to_string(grid.faceCount) + "\n\n";
+    }
+
+    static char* vertex(char* out, const double p[3], const double n[3]) {
+        out = putText(out, "v ");
+        out = Num::put(out, p[0]); *out++ = ' ';
+        out = Num::put(out, p[1]); *out++ = ' ';
+        out = Num::put(out, p[2]); *out++ = '\n';
+        if constexpr (Normals) {
+            out = putText(out, "vn ");
+            out = Num::put(out, n[0]); *out++ = ' ';
+            out = Num::put(out, n[1]); *out++ = ' ';
+            out = Num::put(out, n[2]); *out++ = '\n';
+        }
+        return out;
+    }
+
+    static char* corner(char* out, int32_t index) {
+        out = Num::putIndex(out, index + 1);
+        if constexpr (Normals) {
+            out = putText(out, "//");
+            out = Num::putIndex(out, index + 1);
+        }
+        return out;
+    }
+
+    static char* face(char* out, const MeshCorner& a, const MeshCorner& b, const MeshCorner& c) {
+        out = putText(out, "f ");
+        out = corner(out, a.index); *out++ = ' ';
+        out = corner(out, b.index); *out++ = ' ';
+        out = corner(out, c.index); *out++ = '\n';
+        return out;
+    }
+
+    static std::string footer(const HeightfieldGrid&) { return std::string(); }
+};
+
+template<class Real, bool Binary, bool Normals>
+struct PLYFormat {
+    using Num = MeshNumber<Real, Binary>;
+    static constexpr bool kHasVertexList = true;
+    static constexpr size_t kVertexBytes = 6 * (Num::kMaxBytes + 1) + 1;
+    static constexpr size_t kFaceBytes = 4 * (Num::kMaxBytes + 1) + 1;
+
+    // В двоичном виде записи имеют точный размер
+    static constexpr bool kFixedRecords = Binary;
+    static constexpr size_t kVertexRecord = (Normals ? 6 : 3) * sizeof(Real);
+    static constexpr size_t kFaceRecord = 1 + 3 * sizeof(int32_t);
+
+    static std::string header(const HeightfieldGrid& grid) {
+        const char* type = std::is_same_v<Real, float> ? "float" : "double";
+        std::string h = "ply\n";
+        h += Binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n";
+        h += "comment Generated by Lab4 - 3D Scene Modeling\n";
+        h += "element vertex " + std::to_string(grid.vertexCount) + "\n";
+        for (const char* name : { "x", "y", "z" }) {
+            h += std::string("property ") + type + " " + name + "\n";
+        }
+        if (Normals) {
+            for (const char* name : { "nx", "ny", "nz" }) {
+                h += std::string("property ") + type + " " + name + "\n";
+            }
+        }
+        h += "element face " + std::to_string(grid.faceCount) + "\n";
+        h += "property list uchar int vertex_indices\n";
+        h += "end_header\n";
+        return h;
+    }
+
+    static char* separator(char* out, char c) {
+        if constexpr (!Binary) *out++ = c;
+        return out;
+    }
+
+    static char* vertex(char* out, const double p[3], const double n[3]) {
+        out = Num::put(out, p[0]); out = separator(out, ' ');
+        out = Num::put(out, p[1]); out = separator(out, ' ');
+        out = Num::put(out, p[2]);
+        if constexpr (Normals) {
+            out = separator(out, ' ');
+            out = Num::put(out, n[0]); out = separator(out, ' ');
+            out = Num::put(out, n[1]); out = separator(out, ' ');
+            out = Num::put(out, n[2]);
+        }
+        return separator(out, '\n');
+    }
+
+    static char* face(char* out, const MeshCorner& a, const MeshCorner& b, const MeshCorner& c) {
+        if constexpr (Binary) {
+            *out++ = 3;
+        }
+        else {
+            out = putText(out, "3 ");
+        }
+        out = Num::putIndex(out, a.index); out = separator(out, ' ');
+        out = Num::putIndex(out, b.index); out = separator(out, ' ');
+        out = Num::putIndex(out, c.index);
+        return separator(out, '\n');
+    }
+
+    static std::string footer(const HeightfieldGrid&) { return std::string(); }
+};
+
+template<class Real, bool Binary, bool Normals>
+struct STLFormat {
+    // Двоичный STL по спецификации хранит только float
+    using Num = MeshNumber<float, Binary>;
+    static constexpr bool kHasVertexList = false;
+    static constexpr size_t kVertexBytes = 0;
+    static constexpr size_t kFaceBytes = Binary ? 50 : 12 * Num::kMaxBytes + 128;
+
+    static constexpr bool kFixedRecords = Binary;
+    static constexpr size_t kVertexRecord = 0;
+    static constexpr size_t kFaceRecord = 50;
+
+    static std::string header(const HeightfieldGrid& grid) {
+        if constexpr (Binary) {
+            std::string h(80, '\0');
+            const char title[] = "3D_Model - Generated by Lab4 - 3D Scene Modeling";
+            std::memcpy(&h[0], title, sizeof(title) - 1);
+            const uint32_t count = static_cast<uint32_t>(grid.faceCount);
+            h.append(reinterpret_cast<const char*>(&count), sizeof(count));
+            return h;
+        }
+        else {
+            return "solid 3D_Model\n";
+        }
+    }
+
+    static std::string footer(const HeightfieldGrid&) {
+        return Binary ? std::string() : std::string("endsolid 3D_Model\n");
+    }
+
+    static char* vertex(char* out, const double*, const double*) { return out; }
+
+    static void facetNormal(const MeshCorner& a, const MeshCorner& b, const MeshCorner& c, float n[3]) {
+        const float ux = static_cast<float>(b.p[0] - a.p[0]);
+        const float uy = static_cast<float>(b.p[1] - a.p[1]);
+        const float uz = static_cast<float>(b.p[2] - a.p[2]);
+        const float vx = static_cast<float>(c.p[0] - a.p[0]);
+        const float vy = static_cast<float>(c.p[1] - a.p[1]);
+        const float vz = static_cast<float>(c.p[2] - a.p[2]);
+
+        n[0] = uy * vz - uz * vy;
+        n[1] = uz * vx - ux * vz;
+        n[2] = ux * vy - uy * vx;
+
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0001f) {
+            n[0] /= length; n[1] /= length; n[2] /= length;
+        }
+        else {
+            n[0] = 0.0f; n[1] = 1.0f; n[2] = 0.0f;
+        }
+    }
+
+    static char* point(char* out, const double p[3]) {
+        if constexpr (Binary) {
+            out = Num::put(out, p[0]);
+            out = Num::put(out, p[1]);
+            return Num::put(out, p[2]);
+        }
+        else {
+            out = putText(out, "    vertex ");
+            out = Num::put(out, p[0]); *out++ = ' ';
+            out = Num::put(out, p[1]); *out++ = ' ';
+            out = Num::put(out, p[2]); *out++ = '\n';
+            return out;
+        }
+    }
+
+    static char* face(char* out, const MeshCorner& a, const MeshCorner& b, const MeshCorner& c) {
+        float n[3];
+        facetNormal(a, b, c, n);
+
+        if constexpr (Binary) {
+            out = Num::put(out, n[0]);
+            out = Num::put(out, n[1]);
+            out = Num::put(out, n[2]);
+            out = point(out, a.p);
+            out = point(out, b.p);
+            out = point(out, c.p);
+            *out++ = 0; // attribute byte count
+            *out++ = 0;
+        }
+        else {
+            out = putText(out, "facet normal ");
+            out = Num::put(out, n[0]); *out++ = ' ';
+            out = Num::put(out, n[1]); *out++ = ' ';
+            out = Num::put(out, n[2]); *out++ = '\n';
+            out = putText(out, "  outer loop\n");
+            out = point(out, a.p);
+            out = point(out, b.p);
+            out = point(out, c.p);
+            out = putText(out, "  endloop\nendfacet\n");
+        }
+        return out;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Общий проход по сетке. Вся специфика формата приходит из Format и
+// встраивается компилятором.
+// ---------------------------------------------------------------------------
+template<class Format>
+bool writeHeightfieldMesh(const HeightfieldGrid& grid, OutputSink& sink) {
+    MeshBlockWriter writer(sink);
+    writer.write(Format::header(grid));
+
+    const int width = grid.width;
+    const int height = grid.height;
+
+    if constexpr (Format::kHasVertexList) {
+        for (int i = 0; i < height; i++) {
+            const int32_t* rowIndex = &grid.index[static_cast<size_t>(i) * width];
+            for (int j = 0; j < width; j++) {
+                if (rowIndex[j] < 0) continue;
+
+                double p[3], n[3];
+                grid.position(i, j, p);
+                heightfieldNormal(grid.depthData, i, j, n[0], n[1], n[2]);
+
+                char* out = writer.reserve(Format::kVertexBytes);
+                writer.commit(Format::vertex(out, p, n));
+            }
+        }
+    }
+
+    for (int i = 0; i < height - 1; i++) {
+        const int32_t* top = &grid.index[static_cast<size_t>(i) * width];
+        const int32_t* bottom = top + width;
+        for (int j = 0; j < width - 1; j++) {
+            if ((top[j] | top[j + 1] | bottom[j] | bottom[j + 1]) < 0) continue;
+
+            MeshCorner c1, c2, c3, c4;
+            c1.index = top[j];        grid.position(i, j, c1.p);
+            c2.index = top[j + 1];    grid.position(i, j + 1, c2.p);
+            c3.index = bottom[j];     grid.position(i + 1, j, c3.p);
+            c4.index = bottom[j + 1]; grid.position(i + 1, j + 1, c4.p);
+
+            char* out = writer.reserve(2 * Format::kFaceBytes);
+            out = Format::face(out, c1, c2, c3);
+            out = Format::face(out, c2, c4, c3);
+            writer.commit(out);
+        }
+    }
+
+    writer.write(Format::footer(grid));
+    return writer.finish();
+}
+
+// Выбор специализации по опциям времени выполнения - один раз на файл
+template<template<class, bool, bool> class Format>
+bool writeHeightfieldMesh(const HeightfieldGrid& grid, OutputSink& sink,
+    bool binary, bool normals, bool doublePrecision) {
+    if (binary) {
+        if (doublePrecision) {
+            return normals ? writeHeightfieldMesh<Format<double, true, true>>(grid, sink)
+                : writeHeightfieldMesh<Format<double, true, false>>(grid, sink);
+        }
+        return normals ? writeHeightfieldMesh<Format<float, true, true>>(grid, sink)
+            : writeHeightfieldMesh<Format<float, true, false>>(grid, sink);
+    }
+    if (doublePrecision) {
+        return normals ? writeHeightfieldMesh<Format<double, false, true>>(grid, sink)
+            : writeHeightfieldMesh<Format<double, false, false>>(grid, sink);
+    }
+    return normals ? writeHeightfieldMesh<Format<float, false, true>>(grid, sink)
+        : writeHeightfieldMesh<Format<float, false, false>>(grid, sink);
+}
+
+// ---------------------------------------------------------------------------
+// Двоичные форматы: размер файла известен заранее, поэтому файл создается
+// сразу нужного размера, отображается в память, и строки сетки заполняются
+// параллельно в непересекающиеся диапазоны байт без потоков ввода-вывода.
+// ---------------------------------------------------------------------------
+template<class Format>
+bool writeHeightfieldMeshMapped(const HeightfieldGrid& grid, const std::string& filename) {
+    static_assert(Format::kFixedRecords, "mapped output requires fixed-size records");
+
+    const std::string header = Format::header(grid);
+    const uint64_t vertexBytes = Format::kHasVertexList
+        ? static_cast<uint64_t>(grid.vertexCount) * Format::kVertexRecord : 0;
+    const uint64_t faceBytes = static_cast<uint64_t>(grid.faceCount) * Format::kFaceRecord;
+
+    MappedFile file;
+    if (!file.create(filename, header.size() + vertexBytes + faceBytes)) {
+        return false;
+    }
+
+    char* const base = file.data();
+    std::memcpy(base, header.data(), header.size());
+    char* const vertexBase = base + header.size();
+    char* const faceBase = vertexBase + vertexBytes;
+
+    const int width = grid.width;
+    const int height = grid.height;
+
+    parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; i++) {
+            const int32_t* top = &grid.index[static_cast<size_t>(i) * width];
+
+            if constexpr (Format::kHasVertexList) {
+                for (int j = 0; j < width; j++) {
+                    if (top[j] < 0) continue;
+
+                    double p[3], n[3];
+                    grid.position(i, j, p);
+                    heightfieldNormal(grid.depthData, i, j, n[0], n[1], n[2]);
+                    Format::vertex(vertexBase + static_cast<uint64_t>(top[j]) * Format::kVertexRecord, p, n);
+                }
+            }
+
+            if (i >= height - 1) continue;
+
+            const int32_t* bottom = top + width;
+            char* out = faceBase + static_cast<uint64_t>(grid.rowFaceStart[i]) * Format::kFaceRecord;
+            for (int j = 0; j < width - 1; j++) {
+                if ((top[j] | top[j + 1] | bottom[j] | bottom[j + 1]) < 0) continue;
+
+                MeshCorner c1, c2, c3, c4;
+                c1.index = top[j];        grid.position(i, j, c1.p);
+                c2.index = top[j + 1];    grid.position(i, j + 1, c2.p);
+                c3.index = bottom[j];     grid.position(i + 1, j, c3.p);
+                c4.index = bottom[j + 1]; grid.position(i + 1, j + 1, c4.p);
+
+                out = Format::face(out, c1, c2, c3);
+                out = Format::face(out, c2, c4, c3);
+            }
+        }
+    }, 16);
+
+    return file.close();
+}
+
+template<template<class, bool, bool> class Format>
+bool writeHeightfieldMeshMapped(const HeightfieldGrid& grid, const std::string& filename,
+    bool normals, bool doublePrecision) {
+    if (doublePrecision) {
+        return normals ? writeHeightfieldMeshMapped<Format<double, true, true>>(grid, filename)
+            : writeHeightfieldMeshMapped<Format<double, true, false>>(grid, filename);
+    }
+    return normals ? writeHeightfieldMeshMapped<Format<float, true, true>>(grid, filename)
+        : writeHeightfieldMeshMapped<Format<float, true, false>>(grid, filename);
+}
@@ -0,0 +1,156 @@
+#include "offscreen_context.h"
+#include "gl_functions.h"
+#include <iostream>
+
+#if defined(OFFSCREEN_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#elif defined(OFFSCREEN_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+namespace {
+
+#if defined(OFFSCREEN_EGL)
+void* eglLoader(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+bool initialize(EGLDisplay display) {
+    EGLint major = 0, minor = 0;
+    return display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor);
+}
+
+// Дисплей без оконной системы: первое устройство EGL (GPU без X/Wayland),
+// затем Mesa surfaceless, затем дисплей по умолчанию
+EGLDisplay openDisplay() {
+    const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    const auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+        eglGetProcAddress("eglQueryDevicesEXT"));
+
+    if (getPlatformDisplay != nullptr && queryDevices != nullptr) {
+        EGLDeviceEXT device;
+        EGLint count = 0;
+        if (queryDevices(1, &device, &count) && count > 0) {
+            const EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+            if (initialize(display)) return display;
+        }
+    }
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (getPlatformDisplay != nullptr) {
+        const EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (initialize(display)) return display;
+    }
+#endif
+    const EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    return initialize(display) ? display : EGL_NO_DISPLAY;
+}
+#elif defined(OFFSCREEN_OSMESA)
+void* osmesaLoader(const char* name) {
+    return reinterpret_cast<void*>(OSMesaGetProcAddress(name));
+}
+#endif
+
+}
+
+OffscreenContext::~OffscreenContext() {
+    release();
+}
+
+bool OffscreenContext::create() {
+    release();
+#if defined(OFFSCREEN_EGL)
+    const EGLDisplay eglDisplay = openDisplay();
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        std::cerr << "Ошибка: нет дисплея EGL" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "Ошибка: EGL без OpenGL (только OpenGL ES)" << std::endl;
+        release();
+        return false;
+    }
+
+    // Кадр рисуется в буфер кадра: поверхность 1x1 нужна только драйверам
+    // без EGL_KHR_surfaceless_context
+    const EGLint pbufferAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    const EGLint anyAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint count = 0;
+    const bool pbuffer = eglChooseConfig(eglDisplay, pbufferAttributes, &config, 1, &count) && count > 0;
+    if (!pbuffer && !(eglChooseConfig(eglDisplay, anyAttributes, &config, 1, &count) && count > 0)) {
+        std::cerr << "Ошибка: нет конфигурации EGL для OpenGL" << std::endl;
+        release();
+        return false;
+    }
+
+    EGLSurface eglSurface = EGL_NO_SURFACE;
+    if (pbuffer) {
+        const EGLint size[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        eglSurface = eglCreatePbufferSurface(eglDisplay, config, size);
+    }
+    surface = eglSurface;
+    const EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, nullptr);
+    context = eglContext;
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+        std::cerr << "Ошибка создания контекста EGL: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        release();
+        return false;
+    }
+    GLFunctions::loader = eglLoader;
+    return true;
+#elif defined(OFFSCREEN_OSMESA)
+    const OSMesaContext osmesaContext = OSMesaCreateContextExt(OSMESA_RGBA, 24, 0, 0, nullptr);
+    if (osmesaContext == nullptr) {
+        std::cerr << "Ошибка создания контекста OSMesa" << std::endl;
+        return false;
+    }
+    context = osmesaContext;
+    pixels.assign(4, 0);
+    if (!OSMesaMakeCurrent(osmesaContext, pixels.data(), GL_UNSIGNED_BYTE, 1, 1)) {
+        std::cerr << "Ошибка: контекст OSMesa не стал текущим" << std::endl;
+        release();
+        return false;
+    }
+    GLFunctions::loader = osmesaLoader;
+    return true;
+#else
+    std::cerr << "Ошибка: рендер без окна недоступен, программа собрана без "
+        "OFFSCREEN_EGL и OFFSCREEN_OSMESA" << std::endl;
+    return false;
+#endif
+}
+
+void OffscreenContext::release() {
+#if defined(OFFSCREEN_EGL)
+    if (display != nullptr) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != nullptr) eglDestroyContext(display, context);
+        if (surface != nullptr) eglDestroySurface(display, surface);
+        eglTerminate(display);
+        GLFunctions::loader = nullptr;
+    }
+#elif defined(OFFSCREEN_OSMESA)
+    if (context != nullptr) {
+        OSMesaDestroyContext(static_cast<OSMesaContext>(context));
+        GLFunctions::loader = nullptr;
+    }
+#endif
+    display = nullptr;
+    surface = nullptr;
+    context = nullptr;
+    pixels.clear();
+}
+
+const char* OffscreenContext::backend() const {
+#if defined(OFFSCREEN_EGL)
+    return "EGL";
+#elif defined(OFFSCREEN_OSMESA)
+    return "OSMesa";
+#else
+    return "нет";
+#endif
+}
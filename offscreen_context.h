@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+// Контекст OpenGL без окна и дисплея для render_mode: offscreen. Бэкенд
+// выбирается при сборке: OFFSCREEN_EGL (pbuffer на устройстве EGL, у Mesa -
+// платформа surfaceless) или OFFSCREEN_OSMESA (программный растеризатор
+// Mesa). Кадр рисуется в буфер кадра, поверхность контекста - 1x1. На
+// время жизни контекста GLFunctions загружает функции через его бэкенд.
+class OffscreenContext {
+public:
+    ~OffscreenContext();
+
+    bool create();
+    void release();
+    const char* backend() const;
+
+private:
+    void* display = nullptr;
+    void* surface = nullptr;
+    void* context = nullptr;
+    std::vector<unsigned char> pixels; // поверхность OSMesa
+};
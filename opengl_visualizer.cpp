@@ -1,8 +1,18 @@
 ﻿﻿#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
 #include <windows.h>
 #endif
 
 #include "opengl_visualizer.h"
+#include "gl_functions.h"
+#include "offscreen_context.h"
+#include "software_renderer.h"
+#include "bmp_saver.h"
 #include <GL/freeglut.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
@@ -13,14 +23,29 @@
 #include <fstream>
 #include <string>
 #include <cstdint>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
 
 using namespace std;
 
 // Инициализация статических переменных
 Config OpenGLVisualizer::currentConfig;
-vector<vector<double>> OpenGLVisualizer::depthData;
+float OpenGLVisualizer::materialSpecular[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+float OpenGLVisualizer::materialAmbient[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+ReflectionShader OpenGLVisualizer::shader;
+FrameCapture OpenGLVisualizer::capture;
+FrameProfiler OpenGLVisualizer::profiler;
+bool OpenGLVisualizer::showStats = false;
+unique_ptr<ViewerMesh> OpenGLVisualizer::mesh;
+unique_ptr<ViewerMesh> OpenGLVisualizer::nextMesh;
+ViewerMeshBuilder OpenGLVisualizer::builder;
+long long OpenGLVisualizer::watchedTime = 0;
+uintmax_t OpenGLVisualizer::watchedSize = 0;
 float OpenGLVisualizer::rotationX = 0.0f;
 float OpenGLVisualizer::rotationY = 0.0f;
+float OpenGLVisualizer::turntableAngle = 0.0f;
+bool OpenGLVisualizer::turntable = false;
 float OpenGLVisualizer::zoom = 1.0f;
 bool OpenGLVisualizer::showAxes = true;
 bool OpenGLVisualizer::wireframeMode = false;
@@ -38,8 +63,10 @@ float OpenGLVisualizer::upZ = 0.0f;
 
 int OpenGLVisualizer::windowWidth = 1020;
 int OpenGLVisualizer::windowHeight = 820;
+float OpenGLVisualizer::fieldOfView = 45.0f;
 
 void OpenGLVisualizer::display() {
+    profiler.beginFrame();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 
@@ -50,16 +77,40 @@ void OpenGLVisualizer::display() {
 
     glRotatef(rotationX, 1, 0, 0);
     glRotatef(rotationY, 0, 1, 0);
+    glRotatef(turntableAngle, 0, 0, 1);
 
     if (showAxes) {
         drawAxes();
     }
 
-    if (!depthData.empty()) {
-        drawDepthMapAsQuads();
+    adoptMesh();
+    int triangles = 0, chunks = 0, culledChunks = 0;
+    if (mesh) {
+        drawMesh();
+        if (!mesh->terrain.empty()) {
+            triangles = mesh->terrain.getDrawnTriangles();
+            chunks = mesh->terrain.getDrawnChunks();
+            culledChunks = mesh->terrain.getCulledChunks();
+        }
+        else {
+            triangles = mesh->listTriangles;
+        }
+    }
+    if (showStats) {
+        profiler.drawOverlay(windowWidth, windowHeight);
     }
 
+    // Читается задний буфер, поэтому до обмена; ожидания GPU здесь нет
+    const bool capturePending = capture.endFrame(windowWidth, windowHeight);
+    profiler.endFrame(triangles, chunks, culledChunks);
     glutSwapBuffers();
+
+    if (turntable) {
+        turntableAngle = fmodf(turntableAngle + currentConfig.turntable_step, 360.0f);
+    }
+    if (turntable || capturePending) {
+        glutPostRedisplay();
+    }
 }
 
 void OpenGLVisualizer::drawAxes() {
@@ -88,158 +139,171 @@ void OpenGLVisualizer::drawAxes() {
     glEnable(GL_LIGHTING);
 }
 
-void OpenGLVisualizer::drawDepthMapAsQuads() {
-    if (depthData.empty() || depthData[0].empty()) {
-        return;
+// Масштаб сцены окна, как в Python примере
+static const float kViewerScale = 200.0f;
+
+// Буферов фрагментов на кадр, пока новая сетка готовится к показу
+static const int kPrefetchPerFrame = 16;
+// Период проверки файла карты глубины, мс
+static const int kWatchPeriod = 500;
+
+static const char* reflectionModelName(int model) {
+    switch (model) {
+    case 0: return "Ламберт";
+    case 1: return "Фонга-Блинна";
+    case 2: return "Торренса-Сперроу";
+    default: return "Неизвестно";
     }
+}
 
-    int height = static_cast<int>(depthData.size());
-    int width = static_cast<int>(depthData[0].size());
+void OpenGLVisualizer::requestMesh(vector<vector<double>> data) {
+    // Тени и AO без шейдеров требуют материала в каждой вершине
+    const bool perVertexMaterial = currentConfig.shadows || currentConfig.ambient_occlusion;
+    const bool lod = GLFunctions::loadBuffers() && (!perVertexMaterial || shader.valid());
+    builder.request(std::move(data), currentConfig, kViewerScale, lod);
+}
+
+void OpenGLVisualizer::adoptMesh() {
+    if (!nextMesh) {
+        nextMesh = builder.take();
+        if (!nextMesh) {
+            return;
+        }
+    }
 
-    if (height < 2 || width < 2) {
+    // Пока буферы фрагментов нового вида не загружены, рисуется прежняя сетка
+    if (mesh && !nextMesh->terrain.empty()
+        && !nextMesh->terrain.prefetch(currentConfig.lod_pixel_error, windowHeight, fieldOfView, kPrefetchPerFrame)) {
+        glutPostRedisplay();
+        return;
+    }
+    if (nextMesh->terrain.empty()) {
+        compileDisplayList(*nextMesh);
+    }
+    else {
+        cout << "Сетка по фрагментам " << TerrainLOD::CHUNK_SIZE << "x" << TerrainLOD::CHUNK_SIZE
+            << ": " << nextMesh->terrain.getLevels() << " уровней детализации" << endl;
+    }
+    if (mesh) {
+        mesh->release();
+    }
+    mesh = std::move(nextMesh);
+}
+
+void OpenGLVisualizer::compileDisplayList(ViewerMesh& target) {
+    if (target.indices.empty()) {
         return;
     }
 
-    // Находим максимальную глубину для масштабирования
-    double maxDepth = 1.0;
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            if (depthData[i][j] > maxDepth) {
-                maxDepth = depthData[i][j];
-            }
+    // Список отображения: в тенях гаснут диффузная и зеркальная
+    // составляющие, фоновая ослабляется затенением рельефом
+    const bool perVertexMaterial = !target.shadowMask.empty() || !target.occlusionMask.empty();
+    const size_t indexCount = target.indices.size();
+    target.displayList = glGenLists(1);
+    glNewList(target.displayList, GL_COMPILE);
+    glBegin(GL_TRIANGLES);
+    for (size_t k = 0; k < indexCount; ++k) {
+        const size_t sample = target.samples[k];
+        if (perVertexMaterial) {
+            const float lit = target.shadowMask.empty() ? 1.0f : target.shadowMask[sample];
+            const float open = target.occlusionMask.empty() ? 1.0f : target.occlusionMask[sample];
+            const GLfloat diffuse[] = {
+                currentConfig.material_color.x * lit,
+                currentConfig.material_color.y * lit,
+                currentConfig.material_color.z * lit,
+                1.0f
+            };
+            const GLfloat specular[] = {
+                materialSpecular[0] * lit, materialSpecular[1] * lit, materialSpecular[2] * lit, 1.0f
+            };
+            const GLfloat ambient[] = {
+                materialAmbient[0] * open, materialAmbient[1] * open, materialAmbient[2] * open, 1.0f
+            };
+            glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
+            glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
+            glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
         }
+        const float* vertex = &target.vertices[static_cast<size_t>(target.indices[k]) * 6];
+        glNormal3fv(vertex + 3);
+        glVertex3fv(vertex);
     }
-    if (maxDepth == 0) maxDepth = 1.0;
+    glEnd();
+    glEndList();
+    target.listTriangles = static_cast<int>(indexCount / 3);
+    cout << "Сетка в списке отображения: " << target.vertices.size() / 6 << " вершин, "
+        << indexCount / 3 << " треугольников" << endl;
+
+    // Исходные массивы больше не нужны
+    vector<float>().swap(target.vertices);
+    vector<uint32_t>().swap(target.indices);
+    vector<size_t>().swap(target.samples);
+}
 
-    float scaleFactor = 200.0f; // Как в Python примере
+void OpenGLVisualizer::drawMesh() {
+    if (mesh->empty()) {
+        return;
+    }
 
     if (wireframeMode) {
         glDisable(GL_LIGHTING);
         glColor3f(0.3f, 0.6f, 1.0f);
         glLineWidth(1.0f);
-        glBegin(GL_LINE_LOOP);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
-    else {
-        glBegin(GL_QUADS); // Используем QUADS как в Python примере
-    }
-
-    for (int i = 0; i < height - 1; ++i) {
-        for (int j = 0; j < width - 1; ++j) {
-            // Пропускаем точки с нулевой глубиной (фон)
-            if (depthData[i][j] <= 0.0 || depthData[i][j + 1] <= 0.0 ||
-                depthData[i + 1][j] <= 0.0 || depthData[i + 1][j + 1] <= 0.0) {
-                continue;
-            }
-
-            // Координаты вершин как в Python примере
-            float v1x = (j - width / 2.0f) / width;
-            float v1y = (height / 2.0f - i) / height;
-            float v1z = -static_cast<float>(depthData[i][j]) / maxDepth;
-
-            float v2x = ((j + 1) - width / 2.0f) / width;
-            float v2y = (height / 2.0f - i) / height;
-            float v2z = -static_cast<float>(depthData[i][j + 1]) / maxDepth;
-
-            float v3x = ((j + 1) - width / 2.0f) / width;
-            float v3y = (height / 2.0f - (i + 1)) / height;
-            float v3z = -static_cast<float>(depthData[i + 1][j + 1]) / maxDepth;
-
-            float v4x = (j - width / 2.0f) / width;
-            float v4y = (height / 2.0f - (i + 1)) / height;
-            float v4z = -static_cast<float>(depthData[i + 1][j]) / maxDepth;
-
-            // Масштабируем как в Python примере
-            v1x *= scaleFactor; v1y *= scaleFactor; v1z *= scaleFactor;
-            v2x *= scaleFactor; v2y *= scaleFactor; v2z *= scaleFactor;
-            v3x *= scaleFactor; v3y *= scaleFactor; v3z *= scaleFactor;
-            v4x *= scaleFactor; v4y *= scaleFactor; v4z *= scaleFactor;
-
-            // Вычисляем нормаль
-            float normal[3];
-            calculateQuadNormal(v1x, v1y, v1z, v2x, v2y, v2z,
-                v3x, v3y, v3z, v4x, v4y, v4z,
-                normal[0], normal[1], normal[2]);
-
-            if (!wireframeMode) {
-                // Устанавливаем материал
-                GLfloat materialColor[] = {
-                    currentConfig.material_color.x,
-                    currentConfig.material_color.y,
-                    currentConfig.material_color.z,
-                    1.0f
-                };
-                glMaterialfv(GL_FRONT, GL_DIFFUSE, materialColor);
-
-                // Нормаль для освещения
-                glNormal3f(normal[0], normal[1], normal[2]);
-            }
-
-            // Рисуем вершины
-            glVertex3f(v1x, v1y, v1z);
-            glVertex3f(v2x, v2y, v2z);
-            glVertex3f(v3x, v3y, v3z);
-            glVertex3f(v4x, v4y, v4z);
+
+    if (!mesh->terrain.empty()) {
+        // Освещение в шейдере по текущим параметрам; каркас - одним цветом
+        const bool shaded = shader.valid() && !wireframeMode;
+        if (shaded) {
+            shader.bind(currentConfig);
+        }
+        mesh->terrain.draw(currentConfig.lod_pixel_error, windowHeight, fieldOfView);
+        if (shaded) {
+            shader.unbind();
         }
     }
-
-    glEnd();
+    else {
+        glCallList(mesh->displayList);
+    }
 
     if (wireframeMode) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
         glEnable(GL_LIGHTING);
     }
 }
 
-void OpenGLVisualizer::calculateQuadNormal(float x1, float y1, float z1,
-    float x2, float y2, float z2,
-    float x3, float y3, float z3,
-    float x4, float y4, float z4,
-    float& nx, float& ny, float& nz) {
-    // Вычисляем нормаль для квада как среднее двух треугольников
-    float nx1, ny1, nz1, nx2, ny2, nz2;
-
-    // Нормаль первого треугольника (v1, v2, v3)
-    float u1x = x2 - x1;
-    float u1y = y2 - y1;
-    float u1z = z2 - z1;
-
-    float v1x = x3 - x1;
-    float v1y = y3 - y1;
-    float v1z = z3 - z1;
-
-    nx1 = u1y * v1z - u1z * v1y;
-    ny1 = u1z * v1x - u1x * v1z;
-    nz1 = u1x * v1y - u1y * v1x;
-
-    // Нормаль второго треугольника (v1, v3, v4)
-    float u2x = x3 - x1;
-    float u2y = y3 - y1;
-    float u2z = z3 - z1;
-
-    float v2x = x4 - x1;
-    float v2y = y4 - y1;
-    float v2z = z4 - z1;
-
-    nx2 = u2y * v2z - u2z * v2y;
-    ny2 = u2z * v2x - u2x * v2z;
-    nz2 = u2x * v2y - u2y * v2x;
-
-    // Среднее значение
-    nx = (nx1 + nx2) / 2.0f;
-    ny = (ny1 + ny2) / 2.0f;
-    nz = (nz1 + nz2) / 2.0f;
-
-    // Нормализация
-    float length = sqrtf(nx * nx + ny * ny + nz * nz);
-    if (length > 0.0001f) {
-        nx /= length;
-        ny /= length;
-        nz /= length;
+bool OpenGLVisualizer::depthMapStamp(long long& time, uintmax_t& size) {
+    std::error_code error;
+    const auto stamp = filesystem::last_write_time(currentConfig.depth_map_file, error);
+    if (error) {
+        return false;
     }
-    else {
-        nx = 0.0f;
-        ny = 1.0f;
-        nz = 0.0f;
+    size = filesystem::file_size(currentConfig.depth_map_file, error);
+    if (error) {
+        return false;
     }
+    time = static_cast<long long>(stamp.time_since_epoch().count());
+    return true;
+}
+
+void OpenGLVisualizer::watchDepthMap(int value) {
+    // Измененная карта перечитывается и собирается в фоне, окно
+    // продолжает рисовать текущую сетку
+    long long time = 0;
+    uintmax_t size = 0;
+    if (depthMapStamp(time, size) && (time != watchedTime || size != watchedSize)) {
+        watchedTime = time;
+        watchedSize = size;
+        cout << "Карта глубины изменилась, сетка пересобирается в фоне..." << endl;
+        requestMesh({});
+    }
+    if (!nextMesh) {
+        nextMesh = builder.take();
+    }
+    if (nextMesh) {
+        glutPostRedisplay();
+    }
+    glutTimerFunc(kWatchPeriod, watchDepthMap, value);
 }
 
 void OpenGLVisualizer::keyboard(unsigned char key, int x, int y) {
@@ -251,8 +315,32 @@ void OpenGLVisualizer::keyboard(unsigned char key, int x, int y) {
     case 'q': case 'Q': cameraY += 0.5f; break; // Движение вверх
     case 'e': case 'E': cameraY -= 0.5f; break; // Движение вниз
     case 'r': case 'R': resetView(); break;
+    case 'l': case 'L': requestMesh({}); break; // Перечитать карту глубины
+    case 'm': case 'M': // Следующая модель отражения, без пересборки сетки
+        currentConfig.reflection_model = (currentConfig.reflection_model + 1) % 3;
+        setupMaterial();
+        cout << "Модель отражения: " << reflectionModelName(currentConfig.reflection_model) << endl;
+        break;
+    case '[': case ']': { // Блеск (Фонг-Блинн) или шероховатость (Торренс-Сперроу)
+        const bool more = key == ']';
+        if (currentConfig.reflection_model == 2) {
+            currentConfig.material_roughness = min(max(currentConfig.material_roughness + (more ? -0.05f : 0.05f), 0.05f), 1.0f);
+            cout << "Шероховатость: " << currentConfig.material_roughness << endl;
+        }
+        else {
+            currentConfig.material_shininess = min(max(currentConfig.material_shininess * (more ? 1.25f : 0.8f), 1.0f), 1024.0f);
+            currentConfig.phong_shininess = min(currentConfig.material_shininess, 128.0f);
+            cout << "Блеск: " << currentConfig.material_shininess << endl;
+        }
+        setupMaterial();
+        break;
+    }
+    case 'p': case 'P': capture.captureFrame(); break; // Кадр в BMP
+    case 'v': case 'V': capture.setRecording(!capture.isRecording()); break; // Запись всех кадров
+    case 't': case 'T': turntable = !turntable; break; // Вращение модели
+    case 'f': case 'F': showStats = !showStats; break; // Статистика кадров
     case ' ': wireframeMode = !wireframeMode; break; // Переключение режима
-    case 27: exit(0); break; // ESC для выхода
+    case 27: close(); exit(0); break; // ESC для выхода
     }
     glutPostRedisplay();
 }
@@ -285,10 +373,22 @@ void OpenGLVisualizer::reshape(int width, int height) {
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(45.0, (double)width / height, 0.1, 1000.0); // Как в Python примере
+    gluPerspective(fieldOfView, (double)width / height, 0.1, 1000.0); // Как в Python примере
     glMatrixMode(GL_MODELVIEW);
 }
 
+void OpenGLVisualizer::close() {
+    // Кадры, еще лежащие в буферах пикселей, дописываются до выхода
+    capture.setRecording(false);
+    capture.finish();
+
+    profiler.finish();
+    profiler.printSummary();
+    if (!currentConfig.profile_output.empty()) {
+        profiler.writeCSV(currentConfig.profile_output);
+    }
+}
+
 void OpenGLVisualizer::setupLighting() {
     // Освещение на основе конфигурации
     GLfloat light_position[] = {
@@ -328,7 +428,7 @@ void OpenGLVisualizer::setupLighting() {
 
 void OpenGLVisualizer::setupMaterial() {
     // Настройка материала на основе конфигурации
-    GLfloat material_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    const GLfloat* material_ambient = materialAmbient;
     GLfloat material_diffuse[] = {
         currentConfig.material_color.x,
         currentConfig.material_color.y,
@@ -366,11 +466,16 @@ void OpenGLVisualizer::setupMaterial() {
     glMaterialfv(GL_FRONT, GL_DIFFUSE, material_diffuse);
     glMaterialfv(GL_FRONT, GL_SPECULAR, material_specular);
     glMaterialfv(GL_FRONT, GL_SHININESS, material_shininess);
+    for (int k = 0; k < 4; ++k) {
+        materialSpecular[k] = material_specular[k];
+    }
 }
 
 void OpenGLVisualizer::resetView() {
     rotationX = 0.0f;
     rotationY = 0.0f;
+    turntableAngle = 0.0f;
+    turntable = false;
     zoom = 1.0f;
     cameraX = 0.0f;
     cameraY = 0.0f;
@@ -394,13 +499,19 @@ void OpenGLVisualizer::printControls() {
     cout << "Q/E - движение вверх/вниз" << endl;
     cout << "Стрелки - вращение модели" << endl;
     cout << "Пробел - переключение каркасного режима" << endl;
+    cout << "M - следующая модель отражения" << endl;
+    cout << "[ / ] - меньше/больше блеска (у Торренса-Сперроу - через шероховатость)" << endl;
     cout << "R - сброс вида" << endl;
+    cout << "L - перечитать карту глубины (измененный файл перечитывается сам)" << endl;
+    cout << "T - вращение модели вокруг оси высот" << endl;
+    cout << "P - сохранить кадр в BMP, V - начать/остановить запись кадров" << endl;
+    cout << "F - статистика кадров (время CPU/GPU, треугольники)" << endl;
     cout << "ESC - выход" << endl;
     cout << "===========================\n" << endl;
 }
 
 void OpenGLVisualizer::initialize(int argc, char** argv,
-    const std::vector<std::vector<double>>& data,
+    std::vector<std::vector<double>> data,
     const Config& config) {
 
     cout << "OpenGL инициализация начата..." << endl;
@@ -410,9 +521,7 @@ void OpenGLVisualizer::initialize(int argc, char** argv,
         return;
     }
 
-    depthData = data;
-
-    cout << "Данные загружены: " << depthData.size() << " x " << depthData[0].size() << endl;
+    cout << "Данные загружены: " << data.size() << " x " << data[0].size() << endl;
 
     // Инициализация GLUT как в Python примере
     glutInit(&argc, argv);
@@ -421,16 +530,7 @@ void OpenGLVisualizer::initialize(int argc, char** argv,
     glutInitWindowPosition(100, 100);
     glutCreateWindow("3D Depth Map Visualization - Лабораторная работа 4");
 
-    // Настройка OpenGL
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_NORMALIZE);
-    glShadeModel(GL_SMOOTH);
-
-    // Цвет фона черный как в Python примере
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-
-    // Сохраняем конфигурацию
-    currentConfig = config;
+    setupScene(config);
 
     // Настройка камеры на основе конфигурации
     cameraX = config.viewer_position.x;
@@ -443,21 +543,20 @@ void OpenGLVisualizer::initialize(int argc, char** argv,
     upY = 1.0f;
     upZ = 0.0f;
 
-    // Настройка освещения и материала
-    setupLighting();
-    setupMaterial();
+    capture.initialize(config.capture_output);
+    profiler.initialize();
+
+    // Сетка, тени и AO собираются в фоне; окно открывается сразу и
+    // начинает рисовать сетку, когда она будет готова
+    mesh.reset();
+    nextMesh.reset();
+    depthMapStamp(watchedTime, watchedSize);
+    requestMesh(std::move(data));
 
-    // Устанавливаем режим каркаса если нужно
-    wireframeMode = config.wireframe_mode;
     showAxes = config.show_axes;
+    showStats = config.show_stats;
 
-    cout << "Модель отражения: ";
-    switch (config.reflection_model) {
-    case 0: cout << "Ламберт" << endl; break;
-    case 1: cout << "Фонга-Блинна" << endl; break;
-    case 2: cout << "Торренса-Сперроу" << endl; break;
-    default: cout << "Неизвестно" << endl; break;
-    }
+    cout << "Модель отражения: " << reflectionModelName(config.reflection_model) << endl;
 
     // Устанавливаем функции обратного вызова
     glutDisplayFunc(display);
@@ -466,11 +565,156 @@ void OpenGLVisualizer::initialize(int argc, char** argv,
     glutReshapeFunc(reshape);
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
+    glutCloseFunc(close);
+    glutTimerFunc(kWatchPeriod, watchDepthMap, 0);
 
     cout << "OpenGL визуализация инициализирована!" << endl;
     cout << "Размер окна: " << windowWidth << "x" << windowHeight << endl;
 }
 
+void OpenGLVisualizer::setupScene(const Config& config) {
+    // Настройка OpenGL
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_NORMALIZE);
+    glShadeModel(GL_SMOOTH);
+
+    // Цвет фона черный как в Python примере
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Сохраняем конфигурацию
+    currentConfig = config;
+
+    // Настройка освещения и материала
+    setupLighting();
+    setupMaterial();
+
+    // Модели отражения попиксельно в GLSL, если драйвер дает OpenGL 2.0
+    if (shader.create()) {
+        cout << "Освещение: шейдеры GLSL" << endl;
+    }
+    else {
+        cout << "Шейдеры недоступны, освещение фиксированным конвейером" << endl;
+    }
+
+    // Устанавливаем режим каркаса если нужно
+    wireframeMode = config.wireframe_mode;
+}
+
+bool OpenGLVisualizer::renderOffscreen(std::vector<std::vector<double>> data, const Config& config) {
+    const int width = config.image_width;
+    const int height = config.image_height;
+    if (width <= 0 || height <= 0) {
+        cerr << "Ошибка: некорректный размер изображения " << width << "x" << height << endl;
+        return false;
+    }
+    if (data.empty()) {
+        cerr << "ОШИБКА: Нет данных для визуализации!" << endl;
+        return false;
+    }
+
+    const auto start = chrono::steady_clock::now();
+    OffscreenContext context;
+    if (!context.create()) {
+        return false;
+    }
+    cout << "OpenGL без окна (" << context.backend() << "): " << glGetString(GL_VERSION)
+        << " / " << glGetString(GL_RENDERER) << endl;
+    if (!GLFunctions::loadFramebuffers()) {
+        cerr << "Ошибка: нет буферов кадра (нужен OpenGL 3.0 или ARB_framebuffer_object)" << endl;
+        return false;
+    }
+
+    // Цвет и глубина - в буферах отрисовки размера изображения
+    GLuint framebuffer = 0;
+    GLuint renderbuffers[2] = {};
+    GLFunctions::genFramebuffers(1, &framebuffer);
+    GLFunctions::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLFunctions::genRenderbuffers(2, renderbuffers);
+    GLFunctions::bindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    GLFunctions::renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    GLFunctions::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    GLFunctions::bindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    GLFunctions::renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    GLFunctions::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    GLFunctions::bindRenderbuffer(GL_RENDERBUFFER, 0);
+    auto releaseFramebuffer = [&]() {
+        GLFunctions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLFunctions::deleteRenderbuffers(2, renderbuffers);
+        GLFunctions::deleteFramebuffers(1, &framebuffer);
+    };
+    if (GLFunctions::checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cerr << "Ошибка: буфер кадра " << width << "x" << height << " не поддерживается" << endl;
+        releaseFramebuffer();
+        return false;
+    }
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    // Камера, освещение и материал - как в окне, но вид из camera_*
+    // (как у render_mode: software) в масштабе сцены окна. Оси не рисуются:
+    // подписи требуют GLUT
+    const RenderCamera camera = RenderCamera::fromConfig(config);
+    windowWidth = width;
+    windowHeight = height;
+    fieldOfView = 2.0f * atanf(camera.tanHalfFov) * 180.0f / 3.14159265f;
+    setupScene(config);
+
+    // Сетка собирается тем же сборщиком, что и в окне; здесь ее ждем
+    mesh.reset();
+    nextMesh.reset();
+    requestMesh(std::move(data));
+    nextMesh = builder.wait();
+    if (!nextMesh) {
+        shader.release();
+        releaseFramebuffer();
+        return false;
+    }
+    adoptMesh();
+
+    // Ближняя плоскость - как у software; сцена окна лежит в пределах
+    // нескольких kViewerScale от начала координат
+    const Vector3& eye = camera.position;
+    const double nearPlane = camera.nearPlane * kViewerScale;
+    const double reach = (sqrtf(eye.x * eye.x + eye.y * eye.y + eye.z * eye.z) + 2.0f) * kViewerScale;
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    if (camera.perspective) {
+        gluPerspective(fieldOfView, camera.aspect, nearPlane, reach);
+    }
+    else {
+        const double halfHeight = camera.halfHeight * kViewerScale;
+        glOrtho(-halfHeight * camera.aspect, halfHeight * camera.aspect, -halfHeight, halfHeight, nearPlane, reach);
+    }
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    gluLookAt(eye.x * kViewerScale, eye.y * kViewerScale, eye.z * kViewerScale,
+        (eye.x + camera.forward.x) * kViewerScale, (eye.y + camera.forward.y) * kViewerScale,
+        (eye.z + camera.forward.z) * kViewerScale,
+        camera.up.x, camera.up.y, camera.up.z);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    drawMesh();
+
+    // Строки GL идут снизу вверх, BMPSaver ждет сверху вниз
+    vector<uint8_t> rows(static_cast<size_t>(width) * 3 * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+    const vector<uint8_t> pixels = BMPSaver::flipRows(rows, width, height);
+    const double ms = chrono::duration<double, std::milli>(chrono::steady_clock::now() - start).count();
+    cout << "Кадр OpenGL без окна: " << width << "x" << height;
+    if (!mesh->terrain.empty()) {
+        cout << ", " << mesh->terrain.getDrawnTriangles() << " треугольников";
+    }
+    cout << ", " << ms << " мс" << endl;
+
+    mesh->release();
+    mesh.reset();
+    shader.release();
+    releaseFramebuffer();
+    return BMPSaver::saveFrameBuffer(config.image_output, width, height, pixels);
+}
+
 void OpenGLVisualizer::run() {
     setlocale(LC_ALL, "Russian");
     printControls();
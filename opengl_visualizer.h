@@ -2,18 +2,47 @@
 #define OPENGL_VISUALIZER_H
 
 #include "config_reader.h"
+#include "viewer_mesh.h"
+#include "reflection_shader.h"
+#include "frame_capture.h"
+#include "frame_profiler.h"
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 class OpenGLVisualizer {
 public:
-    static void initialize(int argc, char** argv, const std::vector<std::vector<double>>& depthData, const Config& config);
+    //      
+    static void initialize(int argc, char** argv, std::vector<std::vector<double>> depthData, const Config& config);
     static void run();
 
+    // render_mode: offscreen -  image_width x image_height  image_output
+    //     (EGL  OSMesa)   
+    static bool renderOffscreen(std::vector<std::vector<double>> depthData, const Config& config);
+
 private:
     static Config currentConfig;
-    static std::vector<std::vector<double>> depthData;
+    static float materialSpecular[4];
+    static float materialAmbient[4];
+    static ReflectionShader shader;           //    GPU;  GL 2.0 - GL_LIGHT0
+    static FrameCapture capture;              //    BMP  PBO
+    static FrameProfiler profiler;            //  CPU/GPU   
+    static bool showStats;
+
+    //     ;   ,  
+    // (  )       .
+    //         ;
+    //  VBO (  /AO,      ) -
+    //      .
+    static std::unique_ptr<ViewerMesh> mesh;
+    static std::unique_ptr<ViewerMesh> nextMesh;
+    static ViewerMeshBuilder builder;
+    static long long watchedTime;             //      
+    static uintmax_t watchedSize;
 
     static float rotationX, rotationY;
+    static float turntableAngle;              //     
+    static bool turntable;
     static float zoom;
     static bool showAxes;
     static bool wireframeMode;
@@ -24,16 +53,17 @@ private:
     static float upX, upY, upZ;
 
     static int windowWidth, windowHeight;
+    static float fieldOfView;                 //  , 
 
     //  
     static void display();
     static void drawAxes();
-    static void drawDepthMapAsQuads();
-    static void calculateQuadNormal(float x1, float y1, float z1,
-        float x2, float y2, float z2,
-        float x3, float y3, float z3,
-        float x4, float y4, float z4,
-        float& nx, float& ny, float& nz);
+    static void drawMesh();
+    static void requestMesh(std::vector<std::vector<double>> data);
+    static void adoptMesh();
+    static void compileDisplayList(ViewerMesh& target);
+    static void watchDepthMap(int value);
+    static bool depthMapStamp(long long& time, uintmax_t& size);
 
     //  
     static void keyboard(unsigned char key, int x, int y);
@@ -41,8 +71,10 @@ private:
     static void mouse(int button, int state, int x, int y);
     static void motion(int x, int y);
     static void reshape(int width, int height);
+    static void close();
 
     //  
+    static void setupScene(const Config& config);
     static void setupLighting();
     static void setupMaterial();
     static void resetView();
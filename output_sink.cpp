@@ -0,0 +1,291 @@
+#include "output_sink.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+OutputSink::Backend OutputSink::defaultBackend = OutputSink::STREAM;
+bool OutputSink::defaultDirectIO = false;
+
+void OutputSink::setDefaultBackend(Backend backend, bool directIO) {
+    defaultBackend = backend;
+    defaultDirectIO = directIO;
+}
+
+std::unique_ptr<OutputSink> OutputSink::open(const std::string& filename) {
+    return open(filename, defaultBackend);
+}
+
+std::unique_ptr<OutputSink> OutputSink::open(const std::string& filename, Backend backend) {
+    if (backend == ASYNC) {
+        auto sink = std::make_unique<AsyncFileSink>(filename, defaultDirectIO);
+        if (sink->isOpen()) return sink;
+    }
+    else {
+        auto sink = std::make_unique<StreamSink>(filename);
+        if (sink->isOpen()) return sink;
+    }
+
+    std::cerr << "Ошибка: Не удалось создать файл " << filename << std::endl;
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// StreamSink
+// ---------------------------------------------------------------------------
+
+StreamSink::StreamSink(const std::string& filename)
+    : file(filename, std::ios::binary) {}
+
+StreamSink::~StreamSink() {
+    if (file.is_open()) file.close();
+}
+
+bool StreamSink::write(const char* data, size_t size) {
+    file.write(data, static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
+
+bool StreamSink::close() {
+    if (!file.is_open()) return true;
+    file.close();
+    return !file.fail();
+}
+
+// ---------------------------------------------------------------------------
+// AsyncFileSink
+// ---------------------------------------------------------------------------
+
+static char* allocAligned(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return static_cast<char*>(_aligned_malloc(size, alignment));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) return nullptr;
+    return static_cast<char*>(ptr);
+#endif
+}
+
+static void freeAligned(char* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+AsyncFileSink::AsyncFileSink(const std::string& filename, bool directIO, size_t bufferSize)
+    : capacity((std::max)(kAlignment, (bufferSize + kAlignment - 1) / kAlignment * kAlignment)) {
+    for (auto& buffer : buffers) {
+        buffer.data = allocAligned(capacity, kAlignment);
+        if (!buffer.data) return;
+    }
+
+#ifdef _WIN32
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE h = INVALID_HANDLE_VALUE;
+    if (directIO) {
+        h = CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            flags | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, nullptr);
+        direct = (h != INVALID_HANDLE_VALUE);
+    }
+    if (h == INVALID_HANDLE_VALUE) {
+        h = CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, flags, nullptr);
+    }
+    if (h == INVALID_HANDLE_VALUE) return;
+    handle = h;
+#else
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (directIO) {
+        // Не все файловые системы поддерживают O_DIRECT (например, tmpfs)
+        fd = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        direct = (fd >= 0);
+    }
+#endif
+    if (fd < 0) {
+        fd = ::open(filename.c_str(), flags, 0644);
+    }
+    if (fd < 0) return;
+#endif
+
+    opened = true;
+    ioThread = std::thread(&AsyncFileSink::ioLoop, this);
+}
+
+AsyncFileSink::~AsyncFileSink() {
+    if (opened && !closed) {
+        close();
+    }
+    for (auto& buffer : buffers) {
+        if (buffer.data) freeAligned(buffer.data);
+    }
+}
+
+bool AsyncFileSink::write(const char* data, size_t size) {
+    if (!opened || closed) return false;
+
+    while (size > 0) {
+        Buffer& buffer = buffers[fillIndex];
+        const size_t chunk = (std::min)(size, capacity - buffer.size);
+        std::memcpy(buffer.data + buffer.size, data, chunk);
+        buffer.size += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (buffer.size == capacity && !submit()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Передает заполненный буфер потоку ввода-вывода и переключается на второй
+bool AsyncFileSink::submit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return pending < 0; });
+    if (ioFailed) return false;
+
+    Buffer& buffer = buffers[fillIndex];
+    buffer.offset = fileOffset;
+    fileOffset += buffer.size;
+
+    pending = fillIndex;
+    fillIndex ^= 1;
+    buffers[fillIndex].size = 0;
+
+    lock.unlock();
+    cv.notify_all();
+    return true;
+}
+
+void AsyncFileSink::ioLoop() {
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return pending >= 0 || stopping; });
+        if (pending < 0) return;
+
+        const Buffer& buffer = buffers[pending];
+        lock.unlock();
+
+        const bool ok = writeAt(buffer.data, buffer.size, buffer.offset);
+
+        lock.lock();
+        if (!ok) ioFailed = true;
+        pending = -1;
+        lock.unlock();
+        cv.notify_all();
+    }
+}
+
+bool AsyncFileSink::close() {
+    if (!opened || closed) return !ioFailed;
+    closed = true;
+
+    // Хвост: при O_DIRECT дописываем до границы выравнивания и потом обрезаем
+    Buffer& tail = buffers[fillIndex];
+    const uint64_t totalSize = fileOffset + tail.size;
+    bool ok = true;
+    if (tail.size > 0) {
+        if (direct) {
+            const size_t padded = (tail.size + kAlignment - 1) / kAlignment * kAlignment;
+            std::memset(tail.data + tail.size, 0, padded - tail.size);
+            tail.size = padded;
+        }
+        ok = submit();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return pending < 0; });
+        stopping = true;
+    }
+    cv.notify_all();
+    ioThread.join();
+
+    ok = ok && !ioFailed;
+    if (ok && direct && fileOffset != totalSize) {
+        ok = finalizeSize(totalSize);
+    }
+    closeHandle();
+
+    if (!ok) {
+        std::cerr << "Ошибка: Асинхронная запись в файл не удалась" << std::endl;
+    }
+    return ok;
+}
+
+#ifdef _WIN32
+
+bool AsyncFileSink::writeAt(const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        const DWORD chunk = static_cast<DWORD>((std::min)(size, static_cast<size_t>(1u << 30)));
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle), data, chunk, &written, &ov) || written == 0) {
+            return false;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+bool AsyncFileSink::finalizeSize(uint64_t size) {
+    FILE_END_OF_FILE_INFO info = {};
+    info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    return SetFileInformationByHandle(static_cast<HANDLE>(handle), FileEndOfFileInfo,
+        &info, sizeof(info)) != 0;
+}
+
+void AsyncFileSink::closeHandle() {
+    if (handle) {
+        CloseHandle(static_cast<HANDLE>(handle));
+        handle = nullptr;
+    }
+}
+
+#else
+
+bool AsyncFileSink::writeAt(const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        const ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool AsyncFileSink::finalizeSize(uint64_t size) {
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+}
+
+void AsyncFileSink::closeHandle() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Приемник выходных данных для экспортеров и BMPSaver.
+// Запись идет крупными блоками, поэтому виртуальный вызов на блок не важен.
+class OutputSink {
+public:
+    enum Backend {
+        STREAM = 0,   // синхронный std::ofstream
+        ASYNC = 1     // двойная буферизация + отдельный поток ввода-вывода
+    };
+
+    virtual ~OutputSink() = default;
+
+    virtual bool write(const char* data, size_t size) = 0;
+    virtual bool close() = 0;
+
+    // Создает приемник выбранного по умолчанию типа
+    static std::unique_ptr<OutputSink> open(const std::string& filename);
+    static std::unique_ptr<OutputSink> open(const std::string& filename, Backend backend);
+
+    static void setDefaultBackend(Backend backend, bool directIO = false);
+    static Backend getDefaultBackend() { return defaultBackend; }
+
+private:
+    static Backend defaultBackend;
+    static bool defaultDirectIO;
+};
+
+class StreamSink : public OutputSink {
+public:
+    explicit StreamSink(const std::string& filename);
+    ~StreamSink() override;
+
+    bool isOpen() const { return file.is_open(); }
+    bool write(const char* data, size_t size) override;
+    bool close() override;
+
+private:
+    std::ofstream file;
+};
+
+// Пока один буфер заполняется форматированием, второй пишется на диск
+// потоком ввода-вывода крупными выровненными вызовами pwrite (WriteFile с
+// OVERLAPPED-смещением в Windows). Опционально O_DIRECT/FILE_FLAG_NO_BUFFERING.
+class AsyncFileSink : public OutputSink {
+public:
+    AsyncFileSink(const std::string& filename, bool directIO = false,
+        size_t bufferSize = 8u << 20);
+    ~AsyncFileSink() override;
+
+    bool isOpen() const { return opened; }
+    bool write(const char* data, size_t size) override;
+    bool close() override;
+
+private:
+    static constexpr size_t kAlignment = 4096;
+
+    struct Buffer {
+        char* data = nullptr;
+        size_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    void ioLoop();
+    bool submit();
+    bool writeAt(const char* data, size_t size, uint64_t offset);
+    bool finalizeSize(uint64_t size);
+    void closeHandle();
+
+    Buffer buffers[2];
+    int fillIndex = 0;
+    size_t capacity;
+    uint64_t fileOffset = 0;
+
+    bool opened = false;
+    bool closed = false;
+    bool direct = false;
+
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    std::thread ioThread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    int pending = -1;      // индекс буфера, ожидающего записи
+    bool stopping = false;
+    bool ioFailed = false;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Количество рабочих потоков (не меньше одного)
+inline int workerCount() {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+// Признак того, что поток уже выполняет диапазон parallelFor
+inline bool& insideParallelFor() {
+    thread_local bool inside = false;
+    return inside;
+}
+
+// Делит [begin, end) на непрерывные диапазоны и обрабатывает их параллельно.
+// fn(rangeBegin, rangeEnd) вызывается для каждого диапазона; последний
+// диапазон выполняется в вызывающем потоке. Вложенный вызов (из fn)
+// выполняется последовательно, чтобы не плодить потоков сверх workerCount().
+template<class Fn>
+void parallelFor(int begin, int end, Fn&& fn, int minPerThread = 1) {
+    const int total = end - begin;
+    if (total <= 0) return;
+
+    const int threads = insideParallelFor() ? 1
+        : std::max(1, std::min(workerCount(), total / std::max(1, minPerThread)));
+    if (threads == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    const int chunk = (total + threads - 1) / threads;
+    int start = begin;
+    for (int t = 0; t < threads - 1 && start < end; ++t) {
+        const int stop = std::min(end, start + chunk);
+        pool.emplace_back([&fn, start, stop] {
+            insideParallelFor() = true;
+            fn(start, stop);
+        });
+        start = stop;
+    }
+    if (start < end) {
+        insideParallelFor() = true;
+        fn(start, end);
+        insideParallelFor() = false;
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
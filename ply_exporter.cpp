@@ -1,116 +1,135 @@
 #include "mesh_exporter.h"
-#include <fstream>
+#include "mesh_writer_core.h"
 #include <iostream>
 #include <vector>
-#include <cmath>
+#include <algorithm>
 
-bool PLYExporter::exportMesh(const std::vector<std::vector<double>>& depthData,
-    const std::string& filename,
-    float scale) {
-    if (depthData.empty()) {
-        std::cerr << ":   " << std::endl;
-        return false;
-    }
+//    :  - xyz[, ]  uchar rgb  
+template<class Real, bool Binary, bool Normals>
+static bool writeShadedMesh(const HeightfieldGrid& grid, const std::vector<float>& shade, OutputSink& sink) {
+    using Format = PLYFormat<Real, Binary, Normals>;
+    using Num = MeshNumber<Real, Binary>;
 
-    int height = static_cast<int>(depthData.size());
-    int width = static_cast<int>(depthData[0].size());
+    std::string header = Format::header(grid);
+    header.insert(header.find("element face"),
+        "property uchar red\nproperty uchar green\nproperty uchar blue\n");
 
-    //    
-    int vertexCount = 0;
-    int faceCount = 0;
+    MeshBlockWriter writer(sink);
+    writer.write(header);
 
-    //  : 
+    const int width = grid.width;
+    const int height = grid.height;
     for (int i = 0; i < height; i++) {
+        const size_t row = static_cast<size_t>(i) * width;
         for (int j = 0; j < width; j++) {
-            if (depthData[i][j] > 0.0) {
-                vertexCount++;
+            if (grid.index[row + j] < 0) continue;
+
+            double p[3];
+            grid.position(i, j, p);
+            const int value = static_cast<int>(std::min(std::max(shade[row + j], 0.0f), 1.0f) * 255.0f + 0.5f);
+
+            char* out = writer.reserve(Format::kVertexBytes + 3 * (Num::kMaxBytes + 1));
+            out = Num::put(out, p[0]); out = Format::separator(out, ' ');
+            out = Num::put(out, p[1]); out = Format::separator(out, ' ');
+            out = Num::put(out, p[2]);
+            if constexpr (Normals) {
+                double n[3];
+                heightfieldNormal(grid.depthData, i, j, n[0], n[1], n[2]);
+                for (int k = 0; k < 3; ++k) {
+                    out = Format::separator(out, ' ');
+                    out = Num::put(out, n[k]);
+                }
             }
+            for (int k = 0; k < 3; ++k) {
+                if constexpr (Binary) {
+                    *out++ = static_cast<char>(value);
+                }
+                else {
+                    *out++ = ' ';
+                    out = Num::putIndex(out, value);
+                }
+            }
+            writer.commit(Format::separator(out, '\n'));
         }
     }
 
     for (int i = 0; i < height - 1; i++) {
+        const int32_t* top = &grid.index[static_cast<size_t>(i) * width];
+        const int32_t* bottom = top + width;
         for (int j = 0; j < width - 1; j++) {
-            if (depthData[i][j] > 0.0 && depthData[i][j + 1] > 0.0 &&
-                depthData[i + 1][j] > 0.0 && depthData[i + 1][j + 1] > 0.0) {
-                faceCount += 2;
-            }
+            if ((top[j] | top[j + 1] | bottom[j] | bottom[j + 1]) < 0) continue;
+
+            MeshCorner c1, c2, c3, c4;
+            c1.index = top[j];
+            c2.index = top[j + 1];
+            c3.index = bottom[j];
+            c4.index = bottom[j + 1];
+
+            char* out = writer.reserve(2 * Format::kFaceBytes);
+            out = Format::face(out, c1, c2, c3);
+            out = Format::face(out, c2, c4, c3);
+            writer.commit(out);
         }
     }
+    return writer.finish();
+}
 
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << ":     " << filename << std::endl;
-        return false;
+//     -    
+template<class Real>
+static bool writeShadedMesh(const HeightfieldGrid& grid, const std::vector<float>& shade, OutputSink& sink,
+    bool binary, bool normals) {
+    if (binary) {
+        return normals ? writeShadedMesh<Real, true, true>(grid, shade, sink)
+            : writeShadedMesh<Real, true, false>(grid, shade, sink);
     }
+    return normals ? writeShadedMesh<Real, false, true>(grid, shade, sink)
+        : writeShadedMesh<Real, false, false>(grid, shade, sink);
+}
 
-    //   PLY
-    writeHeader(file, vertexCount, faceCount);
-
-    //  
-    file << "# \n";
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            if (depthData[i][j] <= 0.0) continue;
+bool PLYExporter::exportMesh(const std::vector<std::vector<double>>& depthData,
+    const std::string& filename,
+    float scale) {
+    if (depthData.empty() || depthData[0].empty()) {
+        std::cerr << ":   " << std::endl;
+        return false;
+    }
 
-            double x = (j - width / 2.0) * scale;
-            double y = depthData[i][j] * scale;
-            double z = (i - height / 2.0) * scale;
+    //      
+    HeightfieldGrid grid(depthData, scale);
 
-            file << x << " " << y << " " << z << "\n";
+    bool ok = false;
+    if (vertexShade != nullptr) {
+        if (vertexShade->size() != static_cast<size_t>(grid.width) * grid.height) {
+            std::cerr << ":        " << std::endl;
+            return false;
+        }
+        auto sink = OutputSink::open(filename);
+        if (!sink) {
+            return false;
         }
+        ok = doublePrecision ? writeShadedMesh<double>(grid, *vertexShade, *sink, binary, writeNormals)
+            : writeShadedMesh<float>(grid, *vertexShade, *sink, binary, writeNormals);
+        ok = sink->close() && ok;
     }
-
-    //  
-    file << "# \n";
-    int vertexIndex = 0;
-    std::vector<int> vertexIndices(height * width, -1);
-
-    //    
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            if (depthData[i][j] > 0.0) {
-                vertexIndices[i * width + j] = vertexIndex++;
-            }
+    else if (binary) {
+        //   :       
+        ok = writeHeightfieldMeshMapped<PLYFormat>(grid, filename, writeNormals, doublePrecision);
+    }
+    else {
+        auto sink = OutputSink::open(filename);
+        if (!sink) {
+            return false;
         }
+        ok = writeHeightfieldMesh<PLYFormat>(grid, *sink, false, writeNormals, doublePrecision);
+        ok = sink->close() && ok;
     }
 
-    //  
-    for (int i = 0; i < height - 1; i++) {
-        for (int j = 0; j < width - 1; j++) {
-            if (depthData[i][j] > 0.0 && depthData[i][j + 1] > 0.0 &&
-                depthData[i + 1][j] > 0.0 && depthData[i + 1][j + 1] > 0.0) {
-
-                int idx1 = vertexIndices[i * width + j];
-                int idx2 = vertexIndices[i * width + j + 1];
-                int idx3 = vertexIndices[(i + 1) * width + j];
-                int idx4 = vertexIndices[(i + 1) * width + j + 1];
-
-                if (idx1 >= 0 && idx2 >= 0 && idx3 >= 0) {
-                    file << "3 " << idx1 << " " << idx2 << " " << idx3 << "\n";
-                }
-
-                if (idx2 >= 0 && idx4 >= 0 && idx3 >= 0) {
-                    file << "3 " << idx2 << " " << idx4 << " " << idx3 << "\n";
-                }
-            }
-        }
+    if (!ok) {
+        std::cerr << "    " << filename << std::endl;
+        return false;
     }
 
-    file.close();
     std::cout << "PLY  : " << filename
-        << " (: " << vertexCount << ", : " << faceCount << ")" << std::endl;
+        << " (: " << grid.vertexCount << ", : " << grid.faceCount << ")" << std::endl;
     return true;
 }
-
-void PLYExporter::writeHeader(std::ofstream& file, int vertexCount, int faceCount) {
-    file << "ply\n";
-    file << "format ascii 1.0\n";
-    file << "comment Generated by Lab4 - 3D Scene Modeling\n";
-    file << "element vertex " << vertexCount << "\n";
-    file << "property float x\n";
-    file << "property float y\n";
-    file << "property float z\n";
-    file << "element face " << faceCount << "\n";
-    file << "property list uchar int vertex_indices\n";
-    file << "end_header\n";
-}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "mesh_exporter.h"
+#include "mesh_writer_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <charconv>
+#include <cstdint>
+#include <algorithm>
+
+PointCloudExporter::PointCloudExporter(Format format, int stride, float voxelSize)
+    : format(format), stride(stride < 1 ? 1 : stride), voxelSize(voxelSize) {}
+
+std::string PointCloudExporter::getFormatName() const {
+    switch (format) {
+    case XYZ: return "XYZ (облако точек)";
+    case XYZN: return "XYZN (облако точек с нормалями)";
+    default: return "PLY (облако точек, binary)";
+    }
+}
+
+std::string PointCloudExporter::getFileExtension() const {
+    switch (format) {
+    case XYZ: return "xyz";
+    case XYZN: return "xyzn";
+    default: return "points.ply";
+    }
+}
+
+bool PointCloudExporter::exportMesh(const std::vector<std::vector<double>>& depthData,
+    const std::string& filename,
+    float scale) {
+    if (depthData.empty() || depthData[0].empty()) {
+        std::cerr << "Ошибка: пустые данные глубины" << std::endl;
+        return false;
+    }
+
+    Samples samples;
+    collectSamples(depthData, scale, samples);
+
+    bool ok = false;
+    switch (format) {
+    case XYZ: ok = writeXYZ(samples, filename, false); break;
+    case XYZN: ok = writeXYZ(samples, filename, true); break;
+    default: ok = writeBinaryPLY(samples, filename); break;
+    }
+
+    if (ok) {
+        std::cout << "Облако точек сохранено: " << filename
+            << " (точек: " << samples.x.size() << ")" << std::endl;
+    }
+    return ok;
+}
+
+// Один проход по сетке: прореживание по шагу, отбор по вокселям и нормали
+// сразу пишутся в SoA-массивы, треугольники не строятся вообще
+void PointCloudExporter::collectSamples(const std::vector<std::vector<double>>& depthData,
+    float scale, Samples& samples) const {
+    const int height = static_cast<int>(depthData.size());
+    const int width = static_cast<int>(depthData[0].size());
+
+    const size_t estimate = static_cast<size_t>(height / stride + 1) * (width / stride + 1);
+    for (auto* v : { &samples.x, &samples.y, &samples.z, &samples.nx, &samples.ny, &samples.nz }) {
+        v->reserve(estimate);
+    }
+
+    const bool useVoxels = voxelSize > 0.0f;
+    const double invVoxel = useVoxels ? 1.0 / voxelSize : 0.0;
+    auto rowZ = [&](int i) { return static_cast<float>((i - height / 2.0) * scale); };
+    auto cell = [&](float v) { return static_cast<int64_t>(std::floor(v * invVoxel)); };
+
+    // Строки идут по возрастанию z, поэтому слой вокселей с одним kz
+    // обрабатывается целиком и больше не встречается: занятость хранится
+    // битовой картой (kx, ky) только текущего слоя, после слоя сбрасываются
+    // лишь установленные биты
+    const int64_t kxMin = useVoxels ? cell(static_cast<float>((0 - width / 2.0) * scale)) : 0;
+    const int64_t kxCount = useVoxels ? cell(static_cast<float>((width - 1 - width / 2.0) * scale)) - kxMin + 1 : 0;
+    std::vector<uint64_t> occupied;
+    std::vector<size_t> touched;
+
+    for (int slabBegin = 0; slabBegin < height;) {
+        int slabEnd = slabBegin + stride;
+        int64_t kyMin = 0, kyCount = 0;
+        if (useVoxels) {
+            const int64_t kz = cell(rowZ(slabBegin));
+            while (slabEnd < height && cell(rowZ(slabEnd)) == kz) slabEnd += stride;
+
+            // Высоты слоя задают его размер по ky
+            double minDepth = 0.0, maxDepth = 0.0;
+            bool any = false;
+            for (int i = slabBegin; i < slabEnd && i < height; i += stride) {
+                for (int j = 0; j < width; j += stride) {
+                    const double depth = depthData[i][j];
+                    if (depth <= 0.0) continue;
+                    minDepth = any ? std::min(minDepth, depth) : depth;
+                    maxDepth = any ? std::max(maxDepth, depth) : depth;
+                    any = true;
+                }
+            }
+            if (!any) {
+                slabBegin = slabEnd;
+                continue;
+            }
+            kyMin = cell(static_cast<float>(minDepth * scale));
+            kyCount = cell(static_cast<float>(maxDepth * scale)) - kyMin + 1;
+            const size_t words = static_cast<size_t>((kxCount * kyCount + 63) / 64);
+            if (occupied.size() < words) {
+                occupied.resize(words, 0);
+            }
+        }
+
+        for (int i = slabBegin; i < slabEnd && i < height; i += stride) {
+            const double* row = depthData[i].data();
+            const float z = rowZ(i);
+
+            for (int j = 0; j < width; j += stride) {
+                const double depth = row[j];
+                if (depth <= 0.0) continue; // пропускаем фон
+
+                const float x = static_cast<float>((j - width / 2.0) * scale);
+                const float y = static_cast<float>(depth * scale);
+
+                if (useVoxels) {
+                    // Первый попавший в воксель отсчет остается
+                    const size_t bit = static_cast<size_t>((cell(x) - kxMin) * kyCount + (cell(y) - kyMin));
+                    uint64_t& word = occupied[bit >> 6];
+                    const uint64_t mask = uint64_t(1) << (bit & 63);
+                    if (word & mask) continue;
+                    word |= mask;
+                    touched.push_back(bit >> 6);
+                }
+
+                double nx, ny, nz;
+                heightfieldNormal(depthData, i, j, nx, ny, nz);
+
+                samples.x.push_back(x);
+                samples.y.push_back(y);
+                samples.z.push_back(z);
+                samples.nx.push_back(static_cast<float>(nx));
+                samples.ny.push_back(static_cast<float>(ny));
+                samples.nz.push_back(static_cast<float>(nz));
+            }
+        }
+
+        for (size_t word : touched) {
+            occupied[word] = 0;
+        }
+        touched.clear();
+        slabBegin = slabEnd;
+    }
+}
+
+bool PointCloudExporter::writeBinaryPLY(const Samples& samples, const std::string& filename) const {
+    auto sink = OutputSink::open(filename);
+    if (!sink) {
+        return false;
+    }
+
+    const size_t count = samples.x.size();
+
+    std::string header = "ply\n";
+    header += "format binary_little_endian 1.0\n";
+    header += "comment Generated by Lab4 - 3D Scene Modeling (point cloud)\n";
+    header += "element vertex " + std::to_string(count) + "\n";
+    for (const char* name : { "x", "y", "z", "nx", "ny", "nz" }) {
+        header += std::string("property float ") + name + "\n";
+    }
+    header += "end_header\n";
+
+    // Перекладываем SoA в записи вершин и пишем одним вызовом
+    std::vector<float> records(count * 6);
+    for (size_t k = 0; k < count; ++k) {
+        float* r = &records[k * 6];
+        r[0] = samples.x[k];
+        r[1] = samples.y[k];
+        r[2] = samples.z[k];
+        r[3] = samples.nx[k];
+        r[4] = samples.ny[k];
+        r[5] = samples.nz[k];
+    }
+
+    bool ok = sink->write(header.data(), header.size());
+    ok = ok && sink->write(reinterpret_cast<const char*>(records.data()),
+        records.size() * sizeof(float));
+    return sink->close() && ok;
+}
+
+bool PointCloudExporter::writeXYZ(const Samples& samples, const std::string& filename,
+    bool withNormals) const {
+    auto sink = OutputSink::open(filename);
+    if (!sink) {
+        return false;
+    }
+
+    // Форматируем в собственный буфер и сбрасываем его крупными блоками
+    MeshBlockWriter writer(*sink);
+    using Num = MeshNumber<float, false>;
+
+    const size_t count = samples.x.size();
+    for (size_t k = 0; k < count; ++k) {
+        char* out = writer.reserve(6 * (Num::kMaxBytes + 1));
+        out = std::to_chars(out, out + Num::kMaxBytes, samples.x[k]).ptr; *out++ = ' ';
+        out = std::to_chars(out, out + Num::kMaxBytes, samples.y[k]).ptr; *out++ = ' ';
+        out = std::to_chars(out, out + Num::kMaxBytes, samples.z[k]).ptr;
+        if (withNormals) {
+            *out++ = ' ';
+            out = std::to_chars(out, out + Num::kMaxBytes, samples.nx[k]).ptr; *out++ = ' ';
+            out = std::to_chars(out, out + Num::kMaxBytes, samples.ny[k]).ptr; *out++ = ' ';
+            out = std::to_chars(out, out + Num::kMaxBytes, samples.nz[k]).ptr;
+        }
+        *out++ = '\n';
+        writer.commit(out);
+    }
+
+    const bool ok = writer.finish();
+    return sink->close() && ok;
+}
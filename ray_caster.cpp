@@ -0,0 +1,355 @@
+#include "ray_caster.h"
+#include "bmp_saver.h"
+#include "parallel_utils.h"
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+const float kInfinity = std::numeric_limits<float>::infinity();
+
+inline float dot(const Vector3& a, const Vector3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vector3 cross(const Vector3& a, const Vector3& b) {
+    return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// Луч в координатах сетки: (j, i, высота). Переход из сцены линейный,
+// поэтому параметр t тот же, что в сцене (расстояние вдоль оси камеры).
+struct GridRay {
+    float oj, oi, oz;
+    float dj, di, dz;
+    float invJ, invI;
+};
+
+struct Hit {
+    float t;
+    size_t vertex[3];
+    float weight[3];
+};
+
+// Пересечение с треугольником (Мёллер - Трумбор); u, v - веса b и c
+inline bool intersectTriangle(const GridRay& ray, const Vector3& a, const Vector3& b, const Vector3& c,
+    float tMin, float tMax, float& t, float& u, float& v) {
+    const float tolerance = 2e-3f; // без щелей на общих ребрах и углах ячеек
+    const Vector3 e1 = b - a;
+    const Vector3 e2 = c - a;
+    const Vector3 d(ray.dj, ray.di, ray.dz);
+    const Vector3 p = cross(d, e2);
+    const float det = dot(e1, p);
+    if (fabsf(det) < 1e-12f) return false;
+    const float inv = 1.0f / det;
+
+    const Vector3 s(ray.oj - a.x, ray.oi - a.y, ray.oz - a.z);
+    u = dot(s, p) * inv;
+    if (u < -tolerance || u > 1.0f + tolerance) return false;
+    const Vector3 q = cross(s, e1);
+    v = dot(d, q) * inv;
+    if (v < -tolerance || u + v > 1.0f + tolerance) return false;
+    t = dot(e2, q) * inv;
+    return t >= tMin && t <= tMax;
+}
+
+// Ячейка (ci, cj) - треугольники (v00, v01, v11) и (v00, v11, v10), как в rasterize()
+bool intersectCell(const Heightfield& field, const GridRay& ray, int ci, int cj,
+    float tMin, float tMax, Hit& hit) {
+    const size_t v00 = static_cast<size_t>(ci) * field.cols + cj;
+    const size_t v01 = v00 + 1;
+    const size_t v10 = v00 + field.cols;
+    const size_t v11 = v10 + 1;
+    const Vector3 a(static_cast<float>(cj), static_cast<float>(ci), field.height[v00]);
+    const Vector3 b(cj + 1.0f, static_cast<float>(ci), field.height[v01]);
+    const Vector3 c(cj + 1.0f, ci + 1.0f, field.height[v11]);
+    const Vector3 d(static_cast<float>(cj), ci + 1.0f, field.height[v10]);
+
+    bool found = false;
+    float t, u, v;
+    if (intersectTriangle(ray, a, b, c, tMin, tMax, t, u, v)) {
+        hit = { t, { v00, v01, v11 }, { 1.0f - u - v, u, v } };
+        tMax = t;
+        found = true;
+    }
+    if (intersectTriangle(ray, a, c, d, tMin, tMax, t, u, v)) {
+        hit = { t, { v00, v11, v10 }, { 1.0f - u - v, u, v } };
+        found = true;
+    }
+    return found;
+}
+
+// Спуск по пирамиде: узел пропускается целиком, если высота луча на его
+// отрезке вне [min, max] узла. После шага за узел луч поднимается на уровень
+// выше, узел каждый раз определяется заново по текущей точке.
+bool traceRay(const Heightfield& field, const HeightMipmap& mip, const GridRay& ray,
+    float tBegin, float tEnd, Hit& hit) {
+    const int top = mip.levels() - 1;
+    const int cellsX = field.cols - 1;
+    const int cellsY = field.rows - 1;
+
+    // Ячейка выбирается по точке чуть впереди по лучу (1e-3 ячейки),
+    // чтобы на границе попасть в следующую
+    const float minStep = 1e-4f / std::max({ fabsf(ray.dj), fabsf(ray.di), 1e-6f });
+    const float nudge = 10.0f * minStep;
+    const float slack = 10.0f * minStep;
+
+    int level = top;
+    float t = tBegin;
+    while (t < tEnd) {
+        const int j = std::min(std::max(static_cast<int>(floorf(ray.oj + ray.dj * (t + nudge))), 0), cellsX - 1);
+        const int i = std::min(std::max(static_cast<int>(floorf(ray.oi + ray.di * (t + nudge))), 0), cellsY - 1);
+        const int cj = j >> level;
+        const int ci = i >> level;
+
+        // Выход из узла по j и по i
+        float tExit = tEnd;
+        if (ray.dj > 0.0f) tExit = std::min(tExit, (std::min((cj + 1) << level, cellsX) - ray.oj) * ray.invJ);
+        else if (ray.dj < 0.0f) tExit = std::min(tExit, ((cj << level) - ray.oj) * ray.invJ);
+        if (ray.di > 0.0f) tExit = std::min(tExit, (std::min((ci + 1) << level, cellsY) - ray.oi) * ray.invI);
+        else if (ray.di < 0.0f) tExit = std::min(tExit, ((ci << level) - ray.oi) * ray.invI);
+        tExit = std::max(tExit, t);
+
+        const float za = ray.oz + ray.dz * t;
+        const float zb = ray.oz + ray.dz * tExit;
+        const size_t node = static_cast<size_t>(ci) * mip.cols[level] + cj;
+        const bool overlaps = std::min(za, zb) <= mip.maximum[level][node]
+            && std::max(za, zb) >= mip.minimum[level][node];
+
+        if (overlaps) {
+            if (level > 0) {
+                --level;
+                continue;
+            }
+            if (intersectCell(field, ray, i, j, t - slack, tExit + slack, hit)) {
+                return true;
+            }
+        }
+
+        // Шаг меньше ulp(t) не сдвинул бы луч: берем следующее число
+        const float next = std::max(tExit, t + minStep);
+        t = next > t ? next : std::nextafter(t, kInfinity);
+        if (level < top) ++level;
+    }
+    return false;
+}
+
+}
+
+void HeightMipmap::build(const Heightfield& field) {
+    rows.clear();
+    cols.clear();
+    minimum.clear();
+    maximum.clear();
+    if (field.rows < 2 || field.cols < 2) return;
+
+    // Уровень 0: границы высот квада, фон - пустая ячейка
+    rows.push_back(field.rows - 1);
+    cols.push_back(field.cols - 1);
+    minimum.emplace_back(static_cast<size_t>(rows[0]) * cols[0]);
+    maximum.emplace_back(static_cast<size_t>(rows[0]) * cols[0]);
+    parallelFor(0, rows[0], [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            for (int j = 0; j < cols[0]; ++j) {
+                const size_t v00 = static_cast<size_t>(i) * field.cols + j;
+                const size_t v10 = v00 + field.cols;
+                const size_t cell = static_cast<size_t>(i) * cols[0] + j;
+                if (!field.valid[v00] || !field.valid[v00 + 1] || !field.valid[v10] || !field.valid[v10 + 1]) {
+                    minimum[0][cell] = kInfinity;
+                    maximum[0][cell] = -kInfinity;
+                    continue;
+                }
+                minimum[0][cell] = std::min({ field.height[v00], field.height[v00 + 1],
+                    field.height[v10], field.height[v10 + 1] });
+                maximum[0][cell] = std::max({ field.height[v00], field.height[v00 + 1],
+                    field.height[v10], field.height[v10 + 1] });
+            }
+        }
+    }, 16);
+
+    // Следующие уровни - 2x2 ячейки предыдущего (на нечетном краю - меньше)
+    while (rows.back() > 1 || cols.back() > 1) {
+        const int prevRows = rows.back();
+        const int prevCols = cols.back();
+        const int nextRows = (prevRows + 1) / 2;
+        const int nextCols = (prevCols + 1) / 2;
+        const std::vector<float>& prevMin = minimum.back();
+        const std::vector<float>& prevMax = maximum.back();
+        std::vector<float> nextMin(static_cast<size_t>(nextRows) * nextCols, kInfinity);
+        std::vector<float> nextMax(static_cast<size_t>(nextRows) * nextCols, -kInfinity);
+
+        for (int i = 0; i < prevRows; ++i) {
+            const size_t src = static_cast<size_t>(i) * prevCols;
+            const size_t dst = static_cast<size_t>(i / 2) * nextCols;
+            for (int j = 0; j < prevCols; ++j) {
+                nextMin[dst + j / 2] = std::min(nextMin[dst + j / 2], prevMin[src + j]);
+                nextMax[dst + j / 2] = std::max(nextMax[dst + j / 2], prevMax[src + j]);
+            }
+        }
+
+        rows.push_back(nextRows);
+        cols.push_back(nextCols);
+        minimum.push_back(std::move(nextMin));
+        maximum.push_back(std::move(nextMax));
+    }
+}
+
+bool RayCaster::trace(const std::vector<std::vector<double>>& depthData,
+    const Config& config, GBuffer& gbuffer) {
+    const int W = config.image_width;
+    const int H = config.image_height;
+    if (W <= 0 || H <= 0) {
+        std::cerr << "Ошибка: некорректный размер изображения " << W << "x" << H << std::endl;
+        return false;
+    }
+
+    const int rows = static_cast<int>(depthData.size());
+    const int cols = rows > 0 ? static_cast<int>(depthData[0].size()) : 0;
+    if (rows < 2 || cols < 2) {
+        std::cerr << "Ошибка: карта глубины слишком мала для рендера" << std::endl;
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    gbuffer.resize(W, H);
+    SoftwareRenderer::buildSurface(depthData, config, gbuffer);
+    const Heightfield& field = gbuffer.heightfield;
+
+    HeightMipmap mip;
+    mip.build(field);
+    const int top = mip.levels() - 1;
+    const float zMin = mip.minimum[top][0];
+    const float zMax = mip.maximum[top][0];
+
+    // Нормали вершин - те же разности, что в rasterize()
+    const size_t vertexCount = static_cast<size_t>(rows) * cols;
+    std::vector<float> normX(vertexCount), normY(vertexCount), normZ(vertexCount);
+    parallelFor(0, rows, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                const size_t v = static_cast<size_t>(i) * cols + j;
+                field.normal(i, j, normX[v], normY[v], normZ[v]);
+            }
+        }
+    }, 16);
+
+    const RenderCamera camera = RenderCamera::fromConfig(config);
+    const int tilesX = (W + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCount = tilesX * ((H + TILE_SIZE - 1) / TILE_SIZE);
+    std::atomic<int> nextTile(0);
+    std::atomic<size_t> hits(0);
+
+    // Тайлы раздаются потокам динамически, как при растеризации
+    parallelFor(0, workerCount(), [&](int, int) {
+        size_t tileHits = 0;
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            const int x0 = (tile % tilesX) * TILE_SIZE;
+            const int y0 = (tile / tilesX) * TILE_SIZE;
+            const int x1 = std::min(W, x0 + TILE_SIZE);
+            const int y1 = std::min(H, y0 + TILE_SIZE);
+
+            for (int py = y0; py < y1; ++py) {
+                const float ndcY = 1.0f - (py + 0.5f) / H * 2.0f;
+                for (int px = x0; px < x1; ++px) {
+                    const float ndcX = (px + 0.5f) / W * 2.0f - 1.0f;
+
+                    // Луч пикселя; t - глубина вдоль оси камеры
+                    Vector3 origin = camera.position;
+                    Vector3 dir = camera.forward;
+                    if (camera.perspective) {
+                        dir = dir + camera.right * (ndcX * camera.tanHalfFov * camera.aspect)
+                            + camera.up * (ndcY * camera.tanHalfFov);
+                    }
+                    else {
+                        origin = origin + camera.right * (ndcX * camera.halfHeight * camera.aspect)
+                            + camera.up * (ndcY * camera.halfHeight);
+                    }
+
+                    GridRay ray;
+                    ray.oj = origin.x * cols + cols / 2.0f;
+                    ray.oi = rows / 2.0f - origin.y * rows;
+                    ray.oz = origin.z;
+                    ray.dj = dir.x * cols;
+                    ray.di = -dir.y * rows;
+                    ray.dz = dir.z;
+                    ray.invJ = 1.0f / ray.dj;
+                    ray.invI = 1.0f / ray.di;
+
+                    // Отсечение по коробке сетки
+                    float tBegin = camera.nearPlane;
+                    float tEnd = kInfinity;
+                    auto slab = [&](float o, float d, float lo, float hi) {
+                        if (fabsf(d) < 1e-12f) return o >= lo && o <= hi;
+                        float ta = (lo - o) / d;
+                        float tb = (hi - o) / d;
+                        if (ta > tb) std::swap(ta, tb);
+                        tBegin = std::max(tBegin, ta);
+                        tEnd = std::min(tEnd, tb);
+                        return tBegin <= tEnd;
+                    };
+                    if (!slab(ray.oj, ray.dj, 0.0f, cols - 1.0f)) continue;
+                    if (!slab(ray.oi, ray.di, 0.0f, rows - 1.0f)) continue;
+                    if (!slab(ray.oz, ray.dz, zMin, zMax)) continue;
+
+                    Hit hit;
+                    if (!traceRay(field, mip, ray, tBegin, tEnd, hit)) continue;
+                    ++tileHits;
+
+                    const size_t index = static_cast<size_t>(py) * W + px;
+                    gbuffer.depth[index] = hit.t;
+                    float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+                    for (int k = 0; k < 3; ++k) {
+                        nx += hit.weight[k] * normX[hit.vertex[k]];
+                        ny += hit.weight[k] * normY[hit.vertex[k]];
+                        nz += hit.weight[k] * normZ[hit.vertex[k]];
+                    }
+                    const float len = sqrtf(nx * nx + ny * ny + nz * nz);
+                    const float inv = len > 1e-10f ? 1.0f / len : 0.0f;
+                    gbuffer.normalX[index] = nx * inv;
+                    gbuffer.normalY[index] = len > 1e-10f ? ny * inv : 1.0f;
+                    gbuffer.normalZ[index] = nz * inv;
+                    gbuffer.positionX[index] = origin.x + dir.x * hit.t;
+                    gbuffer.positionY[index] = origin.y + dir.y * hit.t;
+                    gbuffer.positionZ[index] = origin.z + dir.z * hit.t;
+                }
+            }
+        }
+        hits += tileHits;
+    }, 1);
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Трассировка лучей: " << W << "x" << H << ", карта " << cols << "x" << rows
+        << ", уровней пирамиды " << mip.levels() << ", попаданий " << hits << ": " << ms << " мс" << std::endl;
+    return true;
+}
+
+bool RayCaster::render(const std::vector<std::vector<double>>& depthData,
+    const Config& config, std::vector<uint8_t>& pixels) {
+    const auto start = std::chrono::steady_clock::now();
+
+    GBuffer gbuffer;
+    if (!trace(depthData, config, gbuffer)) {
+        return false;
+    }
+    SoftwareRenderer::shade(gbuffer, config, pixels);
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Рендер трассировкой " << config.image_width << "x" << config.image_height
+        << " (" << workerCount() << " потоков): " << ms << " мс" << std::endl;
+    return true;
+}
+
+bool RayCaster::renderToFile(const std::vector<std::vector<double>>& depthData,
+    const Config& config) {
+    std::vector<uint8_t> pixels;
+    if (!render(depthData, config, pixels)) {
+        return false;
+    }
+    return BMPSaver::saveFrameBuffer(config.image_output, config.image_width, config.image_height, pixels);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "config_reader.h"
+#include "heightfield.h"
+#include "software_renderer.h"
+#include <vector>
+#include <cstdint>
+
+// Пирамида минимумов и максимумов высот по ячейкам поля высот. Ячейка
+// уровня 0 - квад из четырех соседних отсчетов (пустая, если среди них есть
+// фон), ячейка уровня L покрывает 2x2 ячейки уровня L-1. Пустые ячейки
+// хранят min = +inf, max = -inf.
+struct HeightMipmap {
+    std::vector<int> rows, cols;                  // размер уровня в ячейках
+    std::vector<std::vector<float>> minimum, maximum;
+
+    void build(const Heightfield& field);
+    int levels() const { return static_cast<int>(rows.size()); }
+};
+
+// Рендер трассировкой лучей прямо по сетке карты глубины (render_mode: raycast).
+// Луч спускается по HeightMipmap и пропускает узлы, диапазон высот которых
+// не пересекается с высотой луча над узлом; в ячейке уровня 0 луч
+// пересекается с теми же двумя треугольниками, что строит rasterize().
+// Стоимость - O(пикселей x log(размер карты)), без зависимости от числа
+// треугольников. Результат - тот же G-буфер, что у растеризации, поэтому
+// освещение, тени и AO - из SoftwareRenderer::shade.
+class RayCaster {
+public:
+    static bool trace(const std::vector<std::vector<double>>& depthData,
+        const Config& config, GBuffer& gbuffer);
+
+    static bool render(const std::vector<std::vector<double>>& depthData,
+        const Config& config, std::vector<uint8_t>& pixels);
+
+    // Рендер и сохранение в config.image_output
+    static bool renderToFile(const std::vector<std::vector<double>>& depthData,
+        const Config& config);
+
+private:
+    static const int TILE_SIZE = 16;
+};
@@ -0,0 +1,173 @@
+#include "reflection_shader.h"
+#include "gl_functions.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Позиция и нормаль - в координатах сцены (сетка окна без преобразований
+// модели), наблюдатель - начало координат вида, переведенное в них же;
+// при ортографии (P[2][3] = 0) направление на него общее - ось z вида
+const char* kVertexSource =
+    "#version 110\n"
+    "varying vec3 normal;\n"
+    "varying vec3 view;\n"
+    "varying vec2 visibility;\n"
+    "void main() {\n"
+    "    normal = gl_Normal;\n"
+    "    if (gl_ProjectionMatrix[2][3] == 0.0)\n"
+    "        view = (gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 1.0, 0.0)).xyz;\n"
+    "    else\n"
+    "        view = (gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 0.0, 1.0)).xyz - gl_Vertex.xyz;\n"
+    "    visibility = gl_MultiTexCoord0.st;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+// Формулы - как brdf::evaluate и SoftwareRenderer::shade
+const char* kFragmentSource =
+    "#version 110\n"
+    "uniform int model;\n"
+    "uniform vec3 lightDir;\n"
+    "uniform vec3 lightColor;\n"
+    "uniform vec3 materialColor;\n"
+    "uniform float intensity;\n"
+    "uniform float shininess;\n"
+    "uniform float alpha2;\n"
+    "uniform float reflectance;\n"
+    "uniform float ambient;\n"
+    "varying vec3 normal;\n"
+    "varying vec3 view;\n"
+    "varying vec2 visibility;\n"
+    "void main() {\n"
+    "    vec3 V = normalize(view);\n"
+    "    vec3 N = normalize(normal);\n"
+    "    if (dot(N, V) < 0.0) N = -N;\n"
+    "    vec3 L = lightDir;\n"
+    "    float NdotL = max(dot(N, L), 0.0);\n"
+    "    vec3 H = normalize(L + V);\n"
+    "    float NdotH = max(dot(N, H), 0.0);\n"
+    "    float NdotV = max(dot(N, V), 0.0);\n"
+    "    float VdotH = max(dot(V, H), 0.0);\n"
+    "    float diffuse = NdotL * intensity;\n"
+    "    float specular = 0.0;\n"
+    "    if (model == 1) {\n"
+    "        float power = NdotH > 0.0 ? pow(NdotH, shininess) : (shininess == 0.0 ? 1.0 : 0.0);\n"
+    "        specular = power * intensity * 0.5;\n"
+    "    }\n"
+    "    else if (model == 2 && NdotV > 0.001 && NdotL > 0.001) {\n"
+    "        float cos2 = NdotH * NdotH;\n"
+    "        float tan2 = (1.0 - cos2) / max(cos2, 1e-10);\n"
+    "        float D = exp(-tan2 / alpha2) / (3.14159265 * alpha2 * cos2 * cos2);\n"
+    "        float tanV2 = (1.0 - NdotV * NdotV) / (NdotV * NdotV);\n"
+    "        float tanL2 = (1.0 - NdotL * NdotL) / (NdotL * NdotL);\n"
+    "        float G = 2.0 / (1.0 + sqrt(1.0 + alpha2 * tanV2)) * 2.0 / (1.0 + sqrt(1.0 + alpha2 * tanL2));\n"
+    "        float c = 1.0 - VdotH;\n"
+    "        float F = reflectance + (1.0 - reflectance) * (c * c * c * c * c);\n"
+    "        diffuse *= 1.0 - F;\n"
+    "        specular = D * G * F / (4.0 * NdotV * NdotL) * intensity;\n"
+    "    }\n"
+    "    else if (model < 0 || model > 2) {\n"
+    "        diffuse = intensity;\n"
+    "    }\n"
+    "    diffuse = diffuse * visibility.s + ambient * visibility.t;\n"
+    "    specular *= visibility.s;\n"
+    "    gl_FragColor = vec4((materialColor * diffuse + vec3(specular)) * lightColor, 1.0);\n"
+    "}\n";
+
+GLuint compile(GLenum type, const char* source) {
+    const GLuint shader = GLFunctions::createShader(type);
+    GLFunctions::shaderSource(shader, 1, &source, nullptr);
+    GLFunctions::compileShader(shader);
+
+    GLint status = 0;
+    GLFunctions::getShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        GLint length = 0;
+        GLFunctions::getShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(std::max(length, 1));
+        GLFunctions::getShaderInfoLog(shader, static_cast<GLsizei>(log.size()), nullptr, log.data());
+        std::cerr << "Ошибка компиляции шейдера: " << log.data() << std::endl;
+        GLFunctions::deleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+}
+
+bool ReflectionShader::create() {
+    release();
+    if (!GLFunctions::loadShaders()) {
+        return false;
+    }
+
+    const GLuint vertex = compile(GL_VERTEX_SHADER, kVertexSource);
+    const GLuint fragment = compile(GL_FRAGMENT_SHADER, kFragmentSource);
+    if (vertex == 0 || fragment == 0) {
+        if (vertex != 0) GLFunctions::deleteShader(vertex);
+        if (fragment != 0) GLFunctions::deleteShader(fragment);
+        return false;
+    }
+
+    program = GLFunctions::createProgram();
+    GLFunctions::attachShader(program, vertex);
+    GLFunctions::attachShader(program, fragment);
+    GLFunctions::linkProgram(program);
+    GLFunctions::deleteShader(vertex);
+    GLFunctions::deleteShader(fragment);
+
+    GLint status = 0;
+    GLFunctions::getProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        GLint length = 0;
+        GLFunctions::getProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(std::max(length, 1));
+        GLFunctions::getProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, log.data());
+        std::cerr << "Ошибка сборки программы шейдеров: " << log.data() << std::endl;
+        release();
+        return false;
+    }
+
+    model = GLFunctions::getUniformLocation(program, "model");
+    lightDir = GLFunctions::getUniformLocation(program, "lightDir");
+    lightColor = GLFunctions::getUniformLocation(program, "lightColor");
+    materialColor = GLFunctions::getUniformLocation(program, "materialColor");
+    intensity = GLFunctions::getUniformLocation(program, "intensity");
+    shininess = GLFunctions::getUniformLocation(program, "shininess");
+    alpha2 = GLFunctions::getUniformLocation(program, "alpha2");
+    reflectance = GLFunctions::getUniformLocation(program, "reflectance");
+    ambient = GLFunctions::getUniformLocation(program, "ambient");
+    return true;
+}
+
+void ReflectionShader::release() {
+    if (program != 0) {
+        GLFunctions::deleteProgram(program);
+        program = 0;
+    }
+}
+
+void ReflectionShader::bind(const Config& config) const {
+    GLFunctions::useProgram(program);
+
+    const Vector3& light = config.light_direction;
+    const float length = sqrtf(light.x * light.x + light.y * light.y + light.z * light.z);
+    const float inv = length > 1e-10f ? 1.0f / length : 0.0f;
+    const float alpha = config.material_roughness * config.material_roughness;
+
+    GLFunctions::uniform1i(model, config.reflection_model);
+    GLFunctions::uniform3f(lightDir, light.x * inv, light.y * inv, light.z * inv);
+    GLFunctions::uniform3f(lightColor, config.light_color.x, config.light_color.y, config.light_color.z);
+    GLFunctions::uniform3f(materialColor, config.material_color.x, config.material_color.y, config.material_color.z);
+    GLFunctions::uniform1f(intensity, config.light_intensity);
+    GLFunctions::uniform1f(shininess, config.material_shininess);
+    GLFunctions::uniform1f(alpha2, std::max(alpha * alpha, 1e-7f));
+    GLFunctions::uniform1f(reflectance, config.material_reflectance);
+    GLFunctions::uniform1f(ambient, config.ambient_intensity);
+}
+
+void ReflectionShader::unbind() const {
+    GLFunctions::useProgram(0);
+}
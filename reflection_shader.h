@@ -0,0 +1,35 @@
+#pragma once
+
+#include "config_reader.h"
+
+// Программа GLSL с моделями отражения brdf.h (Ламберт, Фонг-Блинн,
+// Торренс-Сперроу с распределением Бекмана и Френелем Шлика) для окна.
+// Освещение попиксельное в координатах сцены, как у SoftwareRenderer:
+// направленный источник light_direction, наблюдатель - камера окна,
+// нормаль разворачивается к наблюдателю. Модель и параметры материала -
+// uniform-переменные, поэтому переключаются без пересборки сетки.
+// Доля прямого света и доступность фонового (тени и AO) приходят в
+// текстурных координатах вершины (s, t).
+class ReflectionShader {
+public:
+    // Компиляция и сборка; нужен текущий контекст GL 2.0
+    bool create();
+    void release();
+    bool valid() const { return program != 0; }
+
+    // Включает программу с параметрами из config
+    void bind(const Config& config) const;
+    void unbind() const;
+
+private:
+    unsigned int program = 0;
+    int model = -1;
+    int lightDir = -1;
+    int lightColor = -1;
+    int materialColor = -1;
+    int intensity = -1;
+    int shininess = -1;
+    int alpha2 = -1;
+    int reflectance = -1;
+    int ambient = -1;
+};
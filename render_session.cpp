@@ -0,0 +1,83 @@
+#include "render_session.h"
+#include "bmp_saver.h"
+#include <iostream>
+#include <chrono>
+
+static bool sameVector(const Vector3& a, const Vector3& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+RenderSession::RenderSession(const std::vector<std::vector<double>>& depthData)
+    : depthData(depthData), surfaceValid(false), geometryValid(false),
+    surfacePasses(0), geometryPasses(0), shadingPasses(0) {
+}
+
+// Параметры, от которых зависят поле высот и фоновое затенение
+bool RenderSession::sameSurface(const Config& config) const {
+    const Config& s = surfaceConfig;
+    return config.scale == s.scale
+        && config.ambient_occlusion == s.ambient_occlusion
+        && config.ao_directions == s.ao_directions
+        && config.ao_radius == s.ao_radius;
+}
+
+// Параметры, от которых зависят G-буфер и векторы на камеру
+bool RenderSession::sameGeometry(const Config& config) const {
+    const Config& g = geometryConfig;
+    return sameVector(config.camera_position, g.camera_position)
+        && sameVector(config.camera_target, g.camera_target)
+        && sameVector(config.camera_up, g.camera_up)
+        && config.fov == g.fov
+        && config.projection_type == g.projection_type
+        && config.image_width == g.image_width
+        && config.image_height == g.image_height
+        && config.scale == g.scale;
+}
+
+bool RenderSession::prepare(const Config& config) {
+    if (!(surfaceValid && sameSurface(config))) {
+        SoftwareRenderer::buildSurface(depthData, config, gbuffer);
+        surfaceConfig = config;
+        surfaceValid = true;
+        ++surfacePasses;
+    }
+    if (geometryValid && sameGeometry(config)) {
+        return true;
+    }
+
+    geometryValid = false;
+    if (!SoftwareRenderer::rasterize(depthData, config, gbuffer, true)) {
+        return false;
+    }
+    views.compute(gbuffer, RenderCamera::fromConfig(config));
+    geometryConfig = config;
+    geometryValid = true;
+    ++geometryPasses;
+    return true;
+}
+
+bool RenderSession::render(const Config& config, std::vector<uint8_t>& pixels) {
+    const auto start = std::chrono::steady_clock::now();
+    const bool rebuilt = !(geometryValid && sameGeometry(config));
+    if (!prepare(config)) {
+        return false;
+    }
+
+    SoftwareRenderer::shade(gbuffer, config, pixels, &views);
+    ++shadingPasses;
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Кадр " << shadingPasses << " " << config.image_width << "x" << config.image_height
+        << (rebuilt ? " (растеризация и освещение): " : " (только освещение): ")
+        << ms << " мс" << std::endl;
+    return true;
+}
+
+bool RenderSession::renderToFile(const Config& config) {
+    std::vector<uint8_t> pixels;
+    if (!render(config, pixels)) {
+        return false;
+    }
+    return BMPSaver::saveFrameBuffer(config.image_output, config.image_width, config.image_height, pixels);
+}
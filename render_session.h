@@ -0,0 +1,49 @@
+#pragma once
+
+#include "config_reader.h"
+#include "software_renderer.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Серия безоконных рендеров одной карты глубины. G-буфер (глубина, нормали,
+// позиции) и векторы на камеру хранятся между кадрами и пересчитываются,
+// только если изменились камера, размер кадра или масштаб глубины. Поле
+// высот и фоновое затенение от камеры не зависят и пересчитываются только
+// при смене масштаба или параметров AO. Смена освещения или материала
+// стоит одного прохода освещения.
+class RenderSession {
+public:
+    // Карта глубины должна жить дольше сессии
+    explicit RenderSession(const std::vector<std::vector<double>>& depthData);
+
+    bool render(const Config& config, std::vector<uint8_t>& pixels);
+    bool renderToFile(const Config& config);
+
+    // Готовит G-буфер и векторы на камеру под config без освещения
+    bool prepare(const Config& config);
+
+    // Принудительный пересчет геометрии (например, после смены карты глубины)
+    void invalidate() { geometryValid = surfaceValid = false; }
+
+    const GBuffer& getGBuffer() const { return gbuffer; }
+    const ViewBuffer& getViews() const { return views; }
+    int getSurfacePasses() const { return surfacePasses; }
+    int getGeometryPasses() const { return geometryPasses; }
+    int getShadingPasses() const { return shadingPasses; }
+
+private:
+    bool sameSurface(const Config& config) const;
+    bool sameGeometry(const Config& config) const;
+
+    const std::vector<std::vector<double>>& depthData;
+    GBuffer gbuffer;
+    ViewBuffer views;
+    Config surfaceConfig;
+    Config geometryConfig;
+    bool surfaceValid;
+    bool geometryValid;
+    int surfacePasses;
+    int geometryPasses;
+    int shadingPasses;
+};
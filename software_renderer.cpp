@@ -0,0 +1,642 @@
+#include "software_renderer.h"
+#include "lighting_model.h"
+#include "lighting_batch.h"
+#include "brdf_lut.h"
+#include "bmp_saver.h"
+#include "parallel_utils.h"
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+static const float kInfinity = std::numeric_limits<float>::infinity();
+
+static float dot(const Vector3& a, const Vector3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vector3 cross(const Vector3& a, const Vector3& b) {
+    return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float length(const Vector3& v) {
+    return sqrtf(dot(v, v));
+}
+
+static Vector3 normalize(const Vector3& v) {
+    const float len = length(v);
+    if (len < 1e-10f) return Vector3(0.0f, 1.0f, 0.0f);
+    return v * (1.0f / len);
+}
+
+void GBuffer::resize(int w, int h) {
+    width = w;
+    height = h;
+    const size_t count = static_cast<size_t>(w) * h;
+    depth.assign(count, kInfinity);
+    normalX.assign(count, 0.0f);
+    normalY.assign(count, 0.0f);
+    normalZ.assign(count, 0.0f);
+    positionX.assign(count, 0.0f);
+    positionY.assign(count, 0.0f);
+    positionZ.assign(count, 0.0f);
+}
+
+bool GBuffer::covered(size_t index) const {
+    return depth[index] < kInfinity;
+}
+
+RenderCamera RenderCamera::fromConfig(const Config& config) {
+    RenderCamera camera;
+    camera.position = config.camera_position;
+
+    const Vector3 toTarget = config.camera_target - config.camera_position;
+    const float distance = length(toTarget);
+    camera.forward = distance > 1e-6f ? toTarget * (1.0f / distance) : Vector3(0.0f, 0.0f, -1.0f);
+
+    // Если up параллелен направлению взгляда, берем любую другую ось
+    Vector3 right = cross(camera.forward, config.camera_up);
+    if (length(right) < 1e-6f) {
+        right = cross(camera.forward, fabsf(camera.forward.y) < 0.9f
+            ? Vector3(0.0f, 1.0f, 0.0f) : Vector3(0.0f, 0.0f, 1.0f));
+    }
+    camera.right = normalize(right);
+    camera.up = cross(camera.right, camera.forward);
+
+    camera.perspective = !(config.projection_type == "orthographic" || config.projection_type == "ortho");
+    const float fov = std::min(std::max(config.fov, 1.0f), 179.0f) * static_cast<float>(M_PI) / 180.0f;
+    camera.tanHalfFov = tanf(fov * 0.5f);
+    // Ортографический кадр по высоте совпадает с перспективным на расстоянии до цели
+    camera.halfHeight = std::max(distance, 1e-3f) * camera.tanHalfFov;
+    camera.aspect = config.image_height > 0
+        ? static_cast<float>(config.image_width) / config.image_height : 1.0f;
+    return camera;
+}
+
+Vector3 RenderCamera::viewVector(float px, float py, float pz) const {
+    if (perspective) {
+        return Vector3(position.x - px, position.y - py, position.z - pz);
+    }
+    return Vector3(-forward.x, -forward.y, -forward.z);
+}
+
+// Вершины треугольника tri: два треугольника на квад (i, j) карты глубины
+static inline void triangleVertices(uint32_t tri, int cols, size_t v[3]) {
+    const size_t quad = tri >> 1;
+    const size_t i = quad / (cols - 1);
+    const size_t j = quad % (cols - 1);
+    const size_t v00 = i * cols + j;
+    const size_t v01 = v00 + 1;
+    const size_t v10 = v00 + cols;
+    const size_t v11 = v10 + 1;
+    v[0] = v00;
+    if (tri & 1) { v[1] = v11; v[2] = v10; }
+    else { v[1] = v01; v[2] = v11; }
+}
+
+void SoftwareRenderer::buildSurface(const std::vector<std::vector<double>>& depthData,
+    const Config& config, GBuffer& gbuffer) {
+    gbuffer.heightfield = Heightfield::fromDepth(depthData, config.scale);
+    gbuffer.occlusion.clear();
+    if (config.ambient_occlusion) {
+        HeightfieldLighting::ambientOcclusion(gbuffer.heightfield, config.ao_directions,
+            config.ao_radius, gbuffer.occlusion);
+    }
+}
+
+bool SoftwareRenderer::rasterize(const std::vector<std::vector<double>>& depthData,
+    const Config& config, GBuffer& gbuffer, bool surfaceReady) {
+    const int W = config.image_width;
+    const int H = config.image_height;
+    if (W <= 0 || H <= 0) {
+        std::cerr << "Ошибка: некорректный размер изображения " << W << "x" << H << std::endl;
+        return false;
+    }
+
+    const int rows = static_cast<int>(depthData.size());
+    const int cols = rows > 0 ? static_cast<int>(depthData[0].size()) : 0;
+    if (rows < 2 || cols < 2) {
+        std::cerr << "Ошибка: карта глубины слишком мала для рендера" << std::endl;
+        return false;
+    }
+
+    gbuffer.resize(W, H);
+    if (!surfaceReady) {
+        buildSurface(depthData, config, gbuffer);
+    }
+    const RenderCamera camera = RenderCamera::fromConfig(config);
+    const Heightfield& field = gbuffer.heightfield;
+
+    // Вершины: мировые координаты, нормали и экранная проекция (SoA)
+    const size_t vertexCount = static_cast<size_t>(rows) * cols;
+    std::vector<float> worldX(vertexCount), worldY(vertexCount), worldZ(vertexCount);
+    std::vector<float> normX(vertexCount), normY(vertexCount), normZ(vertexCount);
+    std::vector<float> screenX(vertexCount), screenY(vertexCount), viewDepth(vertexCount);
+    std::vector<uint8_t> valid(vertexCount);
+
+    parallelFor(0, rows, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                const size_t v = static_cast<size_t>(i) * cols + j;
+                valid[v] = field.valid[v];
+
+                const float x = field.x(j);
+                const float y = field.y(i);
+                const float z = field.height[v];
+                worldX[v] = x;
+                worldY[v] = y;
+                worldZ[v] = z;
+                field.normal(i, j, normX[v], normY[v], normZ[v]);
+
+                // Проекция в пиксели (ось y экрана направлена вниз)
+                const Vector3 rel(x - camera.position.x, y - camera.position.y, z - camera.position.z);
+                const float cx = dot(rel, camera.right);
+                const float cy = dot(rel, camera.up);
+                const float cz = dot(rel, camera.forward);
+                viewDepth[v] = cz;
+
+                float px = 0.0f, py = 0.0f;
+                if (camera.perspective) {
+                    if (cz > camera.nearPlane) {
+                        px = cx / (cz * camera.tanHalfFov * camera.aspect);
+                        py = cy / (cz * camera.tanHalfFov);
+                    }
+                }
+                else {
+                    px = cx / (camera.halfHeight * camera.aspect);
+                    py = cy / camera.halfHeight;
+                }
+                screenX[v] = (px * 0.5f + 0.5f) * W;
+                screenY[v] = (0.5f - py * 0.5f) * H;
+            }
+        }
+    }, 16);
+
+    // Распределение треугольников по тайлам: каждая полоса строк карты глубины
+    // заполняет свои корзины, поэтому порядок треугольников в тайле детерминирован
+    const int tilesX = (W + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (H + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCount = tilesX * tilesY;
+    const int quadRows = rows - 1;
+    const int quadCols = cols - 1;
+    const int bands = std::max(1, std::min(workerCount(), quadRows));
+
+    std::vector<std::vector<std::vector<uint32_t>>> bins(bands,
+        std::vector<std::vector<uint32_t>>(tileCount));
+    std::vector<size_t> bandTriangles(bands, 0);
+
+    parallelFor(0, bands, [&](int bandBegin, int bandEnd) {
+        for (int band = bandBegin; band < bandEnd; ++band) {
+            const int rowBegin = quadRows * band / bands;
+            const int rowEnd = quadRows * (band + 1) / bands;
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < quadCols; ++j) {
+                    const size_t v00 = static_cast<size_t>(i) * cols + j;
+                    if (!valid[v00] || !valid[v00 + 1] || !valid[v00 + cols] || !valid[v00 + cols + 1]) {
+                        continue;
+                    }
+
+                    for (uint32_t k = 0; k < 2; ++k) {
+                        const uint32_t tri = static_cast<uint32_t>((static_cast<size_t>(i) * quadCols + j) * 2 + k);
+                        size_t v[3];
+                        triangleVertices(tri, cols, v);
+
+                        // Треугольники, пересекающие ближнюю плоскость, отбрасываются
+                        if (viewDepth[v[0]] <= camera.nearPlane || viewDepth[v[1]] <= camera.nearPlane ||
+                            viewDepth[v[2]] <= camera.nearPlane) {
+                            continue;
+                        }
+
+                        const float minX = std::min({ screenX[v[0]], screenX[v[1]], screenX[v[2]] });
+                        const float maxX = std::max({ screenX[v[0]], screenX[v[1]], screenX[v[2]] });
+                        const float minY = std::min({ screenY[v[0]], screenY[v[1]], screenY[v[2]] });
+                        const float maxY = std::max({ screenY[v[0]], screenY[v[1]], screenY[v[2]] });
+                        if (maxX < 0.0f || maxY < 0.0f || minX >= W || minY >= H) continue;
+
+                        const int tx0 = std::max(0, static_cast<int>(minX)) / TILE_SIZE;
+                        const int tx1 = std::min(W - 1, static_cast<int>(maxX)) / TILE_SIZE;
+                        const int ty0 = std::max(0, static_cast<int>(minY)) / TILE_SIZE;
+                        const int ty1 = std::min(H - 1, static_cast<int>(maxY)) / TILE_SIZE;
+                        for (int ty = ty0; ty <= ty1; ++ty) {
+                            for (int tx = tx0; tx <= tx1; ++tx) {
+                                bins[band][ty * tilesX + tx].push_back(tri);
+                            }
+                        }
+                        ++bandTriangles[band];
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    // Тайлы раздаются потокам динамически: стоимость тайлов сильно различается
+    std::atomic<int> nextTile(0);
+    parallelFor(0, workerCount(), [&](int, int) {
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            const int x0 = (tile % tilesX) * TILE_SIZE;
+            const int y0 = (tile / tilesX) * TILE_SIZE;
+            const int x1 = std::min(W, x0 + TILE_SIZE);
+            const int y1 = std::min(H, y0 + TILE_SIZE);
+
+            for (int band = 0; band < bands; ++band) {
+                for (uint32_t tri : bins[band][tile]) {
+                    size_t v[3];
+                    triangleVertices(tri, cols, v);
+
+                    float ax = screenX[v[0]], ay = screenY[v[0]];
+                    float bx = screenX[v[1]], by = screenY[v[1]];
+                    float cx = screenX[v[2]], cy = screenY[v[2]];
+                    float area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+                    if (fabsf(area) < 1e-12f) continue;
+                    if (area < 0.0f) {
+                        std::swap(v[1], v[2]);
+                        std::swap(bx, cx);
+                        std::swap(by, cy);
+                        area = -area;
+                    }
+
+                    const int minX = std::max(x0, static_cast<int>(floorf(std::min({ ax, bx, cx }))));
+                    const int maxX = std::min(x1 - 1, static_cast<int>(ceilf(std::max({ ax, bx, cx }))));
+                    const int minY = std::max(y0, static_cast<int>(floorf(std::min({ ay, by, cy }))));
+                    const int maxY = std::min(y1 - 1, static_cast<int>(ceilf(std::max({ ay, by, cy }))));
+                    if (minX > maxX || minY > maxY) continue;
+
+                    // Функции ребер A*x + B*y + C, шаг по x добавляет A
+                    const float A0 = by - cy, B0 = cx - bx, C0 = -(A0 * bx + B0 * by);
+                    const float A1 = cy - ay, B1 = ax - cx, C1 = -(A1 * cx + B1 * cy);
+                    const float A2 = ay - by, B2 = bx - ax, C2 = -(A2 * ax + B2 * ay);
+                    const float invArea = 1.0f / area;
+
+                    // Перспективно-корректная интерполяция: веса делятся на глубину
+                    const float iw0 = camera.perspective ? 1.0f / viewDepth[v[0]] : 1.0f;
+                    const float iw1 = camera.perspective ? 1.0f / viewDepth[v[1]] : 1.0f;
+                    const float iw2 = camera.perspective ? 1.0f / viewDepth[v[2]] : 1.0f;
+
+                    for (int py = minY; py <= maxY; ++py) {
+                        const float fy = py + 0.5f;
+                        const float fx = minX + 0.5f;
+                        float w0 = A0 * fx + B0 * fy + C0;
+                        float w1 = A1 * fx + B1 * fy + C1;
+                        float w2 = A2 * fx + B2 * fy + C2;
+
+                        for (int px = minX; px <= maxX; ++px, w0 += A0, w1 += A1, w2 += A2) {
+                            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                            float q0 = w0 * invArea * iw0;
+                            float q1 = w1 * invArea * iw1;
+                            float q2 = w2 * invArea * iw2;
+                            const float norm = 1.0f / (q0 + q1 + q2);
+                            q0 *= norm; q1 *= norm; q2 *= norm;
+
+                            const float depth = q0 * viewDepth[v[0]] + q1 * viewDepth[v[1]] + q2 * viewDepth[v[2]];
+                            const size_t index = static_cast<size_t>(py) * W + px;
+                            if (depth >= gbuffer.depth[index]) continue;
+
+                            gbuffer.depth[index] = depth;
+                            const Vector3 n = normalize(Vector3(
+                                q0 * normX[v[0]] + q1 * normX[v[1]] + q2 * normX[v[2]],
+                                q0 * normY[v[0]] + q1 * normY[v[1]] + q2 * normY[v[2]],
+                                q0 * normZ[v[0]] + q1 * normZ[v[1]] + q2 * normZ[v[2]]));
+                            gbuffer.normalX[index] = n.x;
+                            gbuffer.normalY[index] = n.y;
+                            gbuffer.normalZ[index] = n.z;
+                            gbuffer.positionX[index] = q0 * worldX[v[0]] + q1 * worldX[v[1]] + q2 * worldX[v[2]];
+                            gbuffer.positionY[index] = q0 * worldY[v[0]] + q1 * worldY[v[1]] + q2 * worldY[v[2]];
+                            gbuffer.positionZ[index] = q0 * worldZ[v[0]] + q1 * worldZ[v[1]] + q2 * worldZ[v[2]];
+                        }
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    size_t triangles = 0;
+    for (size_t count : bandTriangles) triangles += count;
+    std::cout << "Растеризация: " << triangles << " треугольников, "
+        << tileCount << " тайлов " << TILE_SIZE << "x" << TILE_SIZE << std::endl;
+    return true;
+}
+
+void ViewBuffer::compute(const GBuffer& gbuffer, const RenderCamera& camera) {
+    if (!camera.perspective) {
+        x.clear();
+        y.clear();
+        z.clear();
+        return;
+    }
+
+    const size_t count = gbuffer.depth.size();
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    parallelFor(0, gbuffer.height, [&](int rowBegin, int rowEnd) {
+        const size_t begin = static_cast<size_t>(rowBegin) * gbuffer.width;
+        const size_t end = static_cast<size_t>(rowEnd) * gbuffer.width;
+        for (size_t i = begin; i < end; ++i) {
+            x[i] = camera.position.x - gbuffer.positionX[i];
+            y[i] = camera.position.y - gbuffer.positionY[i];
+            z[i] = camera.position.z - gbuffer.positionZ[i];
+        }
+    }, 16);
+}
+
+void SoftwareRenderer::shade(const GBuffer& gbuffer, const Config& config,
+    std::vector<uint8_t>& pixels, const ViewBuffer* views) {
+    const int W = gbuffer.width;
+    const int H = gbuffer.height;
+    pixels.assign(static_cast<size_t>(W) * H * 3, 0);
+
+    const RenderCamera camera = RenderCamera::fromConfig(config);
+    const SimdLevel level = LightingBatch::levelFromName(config.shading_simd);
+
+    // Материал связывается один раз на кадр; освещение двустороннее:
+    // нормаль разворачивается к наблюдателю
+    Material material = Material::fromConfig(config);
+    BRDFTables tables;
+    if (config.shading_lut) {
+        tables = BRDFTables::build(material);
+        material.tables = &tables;
+    }
+    ShadingParams params;
+    params.lightDir = config.light_direction;
+    params.viewDir = camera.viewVector(0.0f, 0.0f, 0.0f);
+    params.twoSided = true;
+
+    // Маска теней считается на сетке поля высот и выбирается по точке пикселя
+    std::vector<float> shadow;
+    if (config.shadows) {
+        HeightfieldLighting::shadowMask(gbuffer.heightfield, config.light_direction, shadow);
+    }
+
+    auto toByte = [](float value) {
+        return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+
+    // Строка G-буфера освещается одним пакетом, затем переводится в байты
+    const bool cachedViews = views != nullptr && !views->empty();
+    parallelFor(0, H, [&](int rowBegin, int rowEnd) {
+        std::vector<float> viewX, viewY, viewZ;
+        std::vector<float> diffuse(W), specular(W);
+        if (camera.perspective && !cachedViews) {
+            viewX.resize(W);
+            viewY.resize(W);
+            viewZ.resize(W);
+        }
+
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const size_t row = static_cast<size_t>(y) * W;
+
+            ShadingBatch batch;
+            batch.normalX = gbuffer.normalX.data() + row;
+            batch.normalY = gbuffer.normalY.data() + row;
+            batch.normalZ = gbuffer.normalZ.data() + row;
+            batch.count = static_cast<size_t>(W);
+            batch.diffuse = diffuse.data();
+            batch.specular = specular.data();
+
+            if (cachedViews) {
+                batch.viewX = views->x.data() + row;
+                batch.viewY = views->y.data() + row;
+                batch.viewZ = views->z.data() + row;
+            }
+            else if (camera.perspective) {
+                for (int x = 0; x < W; ++x) {
+                    viewX[x] = camera.position.x - gbuffer.positionX[row + x];
+                    viewY[x] = camera.position.y - gbuffer.positionY[row + x];
+                    viewZ[x] = camera.position.z - gbuffer.positionZ[row + x];
+                }
+                batch.viewX = viewX.data();
+                batch.viewY = viewY.data();
+                batch.viewZ = viewZ.data();
+            }
+
+            LightingBatch::shade(material, params, batch, level);
+
+            for (int x = 0; x < W; ++x) {
+                if (!gbuffer.covered(row + x)) continue;
+                if (!shadow.empty()) {
+                    const float lit = HeightfieldLighting::sample(gbuffer.heightfield, shadow,
+                        gbuffer.positionX[row + x], gbuffer.positionY[row + x]);
+                    diffuse[x] *= lit;
+                    specular[x] *= lit;
+                }
+                // Фоновый свет не зависит от теней, только от затенения рельефом
+                float ambient = material.ambient;
+                if (!gbuffer.occlusion.empty()) {
+                    ambient *= HeightfieldLighting::sample(gbuffer.heightfield, gbuffer.occlusion,
+                        gbuffer.positionX[row + x], gbuffer.positionY[row + x]);
+                }
+                diffuse[x] += ambient;
+                uint8_t* pixel = &pixels[(row + x) * 3];
+                pixel[0] = toByte((material.color.x * diffuse[x] + specular[x]) * config.light_color.x);
+                pixel[1] = toByte((material.color.y * diffuse[x] + specular[x]) * config.light_color.y);
+                pixel[2] = toByte((material.color.z * diffuse[x] + specular[x]) * config.light_color.z);
+            }
+        }
+    }, 8);
+}
+
+bool SoftwareRenderer::render(const std::vector<std::vector<double>>& depthData,
+    const Config& config, std::vector<uint8_t>& pixels) {
+    const auto start = std::chrono::steady_clock::now();
+
+    GBuffer gbuffer;
+    if (!rasterize(depthData, config, gbuffer)) {
+        return false;
+    }
+    shade(gbuffer, config, pixels);
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Рендер " << config.image_width << "x" << config.image_height
+        << " (" << workerCount() << " потоков, освещение "
+        << LightingBatch::levelName(LightingBatch::levelFromName(config.shading_simd))
+        << "): " << ms << " мс" << std::endl;
+    return true;
+}
+
+bool SoftwareRenderer::renderToFile(const std::vector<std::vector<double>>& depthData,
+    const Config& config) {
+    std::vector<uint8_t> pixels;
+    if (!render(depthData, config, pixels)) {
+        return false;
+    }
+    return BMPSaver::saveFrameBuffer(config.image_output, config.image_width, config.image_height, pixels);
+}
+
+bool SoftwareRenderer::relight(const std::vector<std::vector<double>>& depthData,
+    const Config& config, std::vector<uint8_t>& pixels, int& width, int& height) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const int rows = static_cast<int>(depthData.size());
+    const int cols = rows > 0 ? static_cast<int>(depthData[0].size()) : 0;
+    if (rows < 2 || cols < 2) {
+        std::cerr << "Ошибка: карта глубины слишком мала для освещения" << std::endl;
+        return false;
+    }
+    width = cols;
+    height = rows;
+    pixels.assign(static_cast<size_t>(cols) * rows * 3, 0);
+
+    // Те же высоты и нормали, что у вершин в rasterize()
+    double maxDepth = 1.0;
+    for (const auto& row : depthData) {
+        for (double depth : row) {
+            if (depth > maxDepth) maxDepth = depth;
+        }
+    }
+    const float zScale = config.scale / static_cast<float>(maxDepth);
+
+    const SimdLevel level = LightingBatch::levelFromName(config.shading_simd);
+    Material material = Material::fromConfig(config);
+    BRDFTables tables;
+    if (config.shading_lut) {
+        tables = BRDFTables::build(material);
+        material.tables = &tables;
+    }
+
+    // Ортографическая камера над картой: наблюдатель на +z, как у нормалей
+    ShadingParams params;
+    params.lightDir = config.light_direction;
+    params.viewDir = Vector3(0.0f, 0.0f, 1.0f);
+
+    Heightfield field;
+    std::vector<float> shadow, occlusion;
+    if (config.shadows || config.ambient_occlusion) {
+        field = Heightfield::fromDepth(depthData, config.scale);
+    }
+    if (config.shadows) {
+        HeightfieldLighting::shadowMask(field, config.light_direction, shadow);
+    }
+    if (config.ambient_occlusion) {
+        HeightfieldLighting::ambientOcclusion(field, config.ao_directions, config.ao_radius, occlusion);
+    }
+
+    auto toByte = [](float value) {
+        return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+
+    parallelFor(0, rows, [&](int rowBegin, int rowEnd) {
+        // Высоты трех соседних строк и признаки непустой глубины
+        std::vector<float> above(cols), center(cols), below(cols);
+        std::vector<uint8_t> validAbove(cols), validCenter(cols), validBelow(cols);
+        std::vector<float> normalX(cols), normalY(cols), normalZ(cols);
+        std::vector<float> diffuse(cols), specular(cols);
+
+        auto loadRow = [&](int i, std::vector<float>& height, std::vector<uint8_t>& valid) {
+            if (i < 0 || i >= rows) {
+                std::fill(valid.begin(), valid.end(), 0);
+                return;
+            }
+            const double* src = depthData[i].data();
+            for (int j = 0; j < cols; ++j) {
+                height[j] = -static_cast<float>(src[j]) * zScale;
+                valid[j] = src[j] > 0.0 ? 1 : 0;
+            }
+        };
+
+        loadRow(rowBegin - 1, above, validAbove);
+        loadRow(rowBegin, center, validCenter);
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            loadRow(i + 1, below, validBelow);
+
+            // Центральные разности без ветвлений: цикл векторизуется компилятором
+            const float scaleX = -0.5f * cols;
+            const float scaleY = 0.5f * rows;
+            normalX[0] = normalX[cols - 1] = 0.0f;
+            for (int j = 1; j + 1 < cols; ++j) {
+                normalX[j] = (center[j + 1] - center[j - 1]) * scaleX;
+            }
+            for (int j = 0; j < cols; ++j) {
+                normalY[j] = (below[j] - above[j]) * scaleY;
+            }
+
+            // Край карты и границы фона - односторонние разности, как в rasterize()
+            for (int j = 0; j < cols; ++j) {
+                if (!validCenter[j]) continue;
+                const bool left = j > 0 && validCenter[j - 1];
+                const bool right = j + 1 < cols && validCenter[j + 1];
+                const bool top = validAbove[j] != 0;
+                const bool bottom = validBelow[j] != 0;
+                if (!(left && right)) {
+                    float dzdj = 0.0f;
+                    if (right) dzdj = center[j + 1] - center[j];
+                    else if (left) dzdj = center[j] - center[j - 1];
+                    normalX[j] = -dzdj * cols;
+                }
+                if (!(top && bottom)) {
+                    float dzdi = 0.0f;
+                    if (bottom) dzdi = below[j] - center[j];
+                    else if (top) dzdi = center[j] - above[j];
+                    normalY[j] = dzdi * rows;
+                }
+            }
+
+            for (int j = 0; j < cols; ++j) {
+                const float inv = 1.0f / sqrtf(normalX[j] * normalX[j] + normalY[j] * normalY[j] + 1.0f);
+                normalX[j] *= inv;
+                normalY[j] *= inv;
+                normalZ[j] = inv;
+            }
+
+            ShadingBatch batch;
+            batch.normalX = normalX.data();
+            batch.normalY = normalY.data();
+            batch.normalZ = normalZ.data();
+            batch.count = static_cast<size_t>(cols);
+            batch.diffuse = diffuse.data();
+            batch.specular = specular.data();
+            LightingBatch::shade(material, params, batch, level);
+
+            uint8_t* out = &pixels[static_cast<size_t>(i) * cols * 3];
+            if (!shadow.empty()) {
+                const float* lit = &shadow[static_cast<size_t>(i) * cols];
+                for (int j = 0; j < cols; ++j) {
+                    diffuse[j] *= lit[j];
+                    specular[j] *= lit[j];
+                }
+            }
+            if (!occlusion.empty()) {
+                const float* ao = &occlusion[static_cast<size_t>(i) * cols];
+                for (int j = 0; j < cols; ++j) {
+                    diffuse[j] += material.ambient * ao[j];
+                }
+            }
+            else {
+                for (int j = 0; j < cols; ++j) {
+                    diffuse[j] += material.ambient;
+                }
+            }
+            for (int j = 0; j < cols; ++j) {
+                if (!validCenter[j]) continue;
+                out[j * 3 + 0] = toByte((material.color.x * diffuse[j] + specular[j]) * config.light_color.x);
+                out[j * 3 + 1] = toByte((material.color.y * diffuse[j] + specular[j]) * config.light_color.y);
+                out[j * 3 + 2] = toByte((material.color.z * diffuse[j] + specular[j]) * config.light_color.z);
+            }
+
+            above.swap(center);
+            center.swap(below);
+            validAbove.swap(validCenter);
+            validCenter.swap(validBelow);
+        }
+    }, 16);
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Освещение карты глубины " << cols << "x" << rows
+        << " (" << workerCount() << " потоков, освещение " << LightingBatch::levelName(level)
+        << "): " << ms << " мс" << std::endl;
+    return true;
+}
+
+bool SoftwareRenderer::relightToFile(const std::vector<std::vector<double>>& depthData,
+    const Config& config) {
+    std::vector<uint8_t> pixels;
+    int width = 0, height = 0;
+    if (!relight(depthData, config, pixels, width, height)) {
+        return false;
+    }
+    return BMPSaver::saveFrameBuffer(config.image_output, width, height, pixels);
+}
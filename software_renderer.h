@@ -0,0 +1,87 @@
+#pragma once
+
+#include "config_reader.h"
+#include "heightfield.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Результат растеризации до освещения: по одному значению на пиксель (SoA).
+// Фоновые пиксели имеют depth = +inf.
+struct GBuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<float> depth;                           // расстояние вдоль оси камеры
+    std::vector<float> normalX, normalY, normalZ;       // интерполированная нормаль (мир)
+    std::vector<float> positionX, positionY, positionZ; // точка поверхности (мир)
+    Heightfield heightfield;                            // исходная сетка (для теней)
+    std::vector<float> occlusion;                       // фоновое затенение на сетке (пусто - без AO)
+
+    void resize(int w, int h);
+    bool covered(size_t index) const;
+};
+
+// Камера из Config в виде, удобном для растеризации
+struct RenderCamera {
+    Vector3 position;
+    Vector3 right, up, forward;   // ортонормированный базис, forward - от камеры к цели
+    bool perspective = true;
+    float tanHalfFov = 0.0f;      // для перспективы
+    float halfHeight = 0.0f;      // для ортографии (мировые единицы)
+    float aspect = 1.0f;
+    float nearPlane = 0.1f;
+
+    static RenderCamera fromConfig(const Config& config);
+
+    // Направление на камеру из точки поверхности (ненормированное)
+    Vector3 viewVector(float px, float py, float pz) const;
+};
+
+// Векторы на камеру (ненормированные) для каждого пикселя G-буфера.
+// При ортографии пусты: направление общее для кадра.
+struct ViewBuffer {
+    std::vector<float> x, y, z;
+
+    void compute(const GBuffer& gbuffer, const RenderCamera& camera);
+    bool empty() const { return x.empty(); }
+};
+
+// Безоконный рендер карты глубины на CPU. Сцена строится в тех же координатах,
+// что и в OpenGLVisualizer (без множителя 200), кадр делится на тайлы,
+// которые растеризуются параллельно в G-буфер, затем он освещается
+// построчно пакетами LightingBatch (те же модели, что в LightingModel).
+class SoftwareRenderer {
+public:
+    // Пиксели RGB, строки сверху вниз, размер config.image_width x image_height
+    static bool render(const std::vector<std::vector<double>>& depthData,
+        const Config& config, std::vector<uint8_t>& pixels);
+
+    // Рендер и сохранение в config.image_output
+    static bool renderToFile(const std::vector<std::vector<double>>& depthData,
+        const Config& config);
+
+    // surfaceReady - gbuffer.heightfield и occlusion уже построены под config
+    static bool rasterize(const std::vector<std::vector<double>>& depthData,
+        const Config& config, GBuffer& gbuffer, bool surfaceReady = false);
+
+    // Поле высот и фоновое затенение в gbuffer: от камеры не зависят
+    static void buildSurface(const std::vector<std::vector<double>>& depthData,
+        const Config& config, GBuffer& gbuffer);
+
+    // views - заранее посчитанные векторы на камеру; без них считаются по строкам
+    static void shade(const GBuffer& gbuffer, const Config& config,
+        std::vector<uint8_t>& pixels, const ViewBuffer* views = nullptr);
+
+    // Освещение прямо по карте глубины, без геометрии: ортографический вид
+    // сверху, нормали по градиентам глубины, кадр размером с карту глубины.
+    // Фон (глубина <= 0) - черный.
+    static bool relight(const std::vector<std::vector<double>>& depthData,
+        const Config& config, std::vector<uint8_t>& pixels, int& width, int& height);
+
+    // Освещение по карте глубины и сохранение в config.image_output
+    static bool relightToFile(const std::vector<std::vector<double>>& depthData,
+        const Config& config);
+
+private:
+    static const int TILE_SIZE = 32;
+};
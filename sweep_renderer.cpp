@@ -0,0 +1,132 @@
+#include "sweep_renderer.h"
+#include "render_session.h"
+#include "software_renderer.h"
+#include "bmp_saver.h"
+#include "parallel_utils.h"
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Параметры кадра, не влияющие на геометрию
+struct ShadingVariant {
+    Vector3 light;
+    int model;
+    float shininess;
+    float roughness;
+};
+
+template<class T>
+std::vector<T> orDefault(const std::vector<T>& values, const T& fallback) {
+    return values.empty() ? std::vector<T>{ fallback } : values;
+}
+
+}
+
+Vector3 SweepRenderer::orbitCamera(const Config& config, float degrees) {
+    // Поворот Родрига вектора от цели к камере вокруг оси camera_up
+    Vector3 k = config.camera_up;
+    const float len = sqrtf(k.x * k.x + k.y * k.y + k.z * k.z);
+    if (len < 1e-6f) return config.camera_position;
+    k = k * (1.0f / len);
+
+    const Vector3 v = config.camera_position - config.camera_target;
+    const float angle = degrees * static_cast<float>(M_PI) / 180.0f;
+    const float c = cosf(angle), s = sinf(angle);
+    const float kv = k.x * v.x + k.y * v.y + k.z * v.z;
+    const Vector3 kxv(k.y * v.z - k.z * v.y, k.z * v.x - k.x * v.z, k.x * v.y - k.y * v.x);
+    const Vector3 rotated = v * c + kxv * s + k * (kv * (1.0f - c));
+    return config.camera_target + rotated;
+}
+
+bool SweepRenderer::run(const std::vector<std::vector<double>>& depthData, const Config& config) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::vector<Vector3> lights = orDefault(config.sweep_lights, config.light_direction);
+    const std::vector<int> models = orDefault(config.sweep_models, config.reflection_model);
+    const std::vector<float> shininess = orDefault(config.sweep_shininess, config.material_shininess);
+    const std::vector<float> roughness = orDefault(config.sweep_roughness, config.material_roughness);
+    const std::vector<float> orbit = orDefault(config.sweep_orbit, 0.0f);
+
+    std::vector<ShadingVariant> variants;
+    for (const Vector3& light : lights)
+        for (int model : models)
+            for (float s : shininess)
+                for (float r : roughness)
+                    variants.push_back({ light, model, s, r });
+
+    const int variantCount = static_cast<int>(variants.size());
+    const int frameCount = variantCount * static_cast<int>(orbit.size());
+    std::cout << "Серия: " << frameCount << " кадров (" << orbit.size() << " ракурсов x "
+        << variantCount << " вариантов освещения)" << std::endl;
+
+    // Список кадров с параметрами
+    const std::string manifestPath = BMPSaver::outputStem(config.image_output) + "_sweep.txt";
+    std::ofstream manifest(manifestPath);
+    if (!manifest.is_open()) {
+        std::cerr << "Ошибка создания файла " << manifestPath << std::endl;
+        return false;
+    }
+    manifest << "# кадр; облет, град; свет; модель; блеск; шероховатость\n";
+
+    RenderSession session(depthData);
+    std::atomic<bool> ok(true);
+
+    for (size_t o = 0; o < orbit.size(); ++o) {
+        Config view = config;
+        view.camera_position = orbitCamera(config, orbit[o]);
+        if (!session.prepare(view)) {
+            return false;
+        }
+
+        const int firstFrame = static_cast<int>(o) * variantCount + 1;
+        for (int v = 0; v < variantCount; ++v) {
+            const ShadingVariant& variant = variants[v];
+            manifest << BMPSaver::framePath(config.image_output, firstFrame + v) << "; " << orbit[o]
+                << "; " << variant.light.x << "," << variant.light.y << "," << variant.light.z
+                << "; " << variant.model << "; " << variant.shininess << "; " << variant.roughness << "\n";
+        }
+
+        auto renderVariant = [&](int v) {
+            Config frame = view;
+            frame.light_direction = variants[v].light;
+            frame.reflection_model = variants[v].model;
+            frame.material_shininess = variants[v].shininess;
+            frame.material_roughness = variants[v].roughness;
+
+            std::vector<uint8_t> pixels;
+            SoftwareRenderer::shade(session.getGBuffer(), frame, pixels, &session.getViews());
+            if (!BMPSaver::saveFrameBuffer(BMPSaver::framePath(config.image_output, firstFrame + v),
+                frame.image_width, frame.image_height, pixels)) {
+                ok = false;
+            }
+        };
+
+        // Вариантов хватает на все потоки - по кадру на поток (вложенные
+        // parallelFor освещения и записи идут последовательно), иначе
+        // каждый кадр параллелится по строкам
+        if (variantCount >= workerCount()) {
+            parallelFor(0, variantCount, [&](int begin, int end) {
+                for (int v = begin; v < end; ++v) renderVariant(v);
+            });
+        }
+        else {
+            for (int v = 0; v < variantCount; ++v) renderVariant(v);
+        }
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Серия готова: " << frameCount << " кадров, " << session.getGeometryPasses()
+        << " растеризаций, " << ms << " мс (" << ms / std::max(1, frameCount) << " мс на кадр), "
+        << "список кадров: " << manifestPath << std::endl;
+    return ok;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "config_reader.h"
+#include <string>
+#include <vector>
+
+// Серия безоконных рендеров одной карты глубины (render_mode: sweep):
+// все сочетания sweep_lights x sweep_models x sweep_shininess x
+// sweep_roughness для каждого угла sweep_orbit. G-буфер строится один раз
+// на ракурс (RenderSession), варианты освещения считаются параллельно.
+// Кадры пишутся как <image_output без .bmp>_0001.bmp, ..., параметры
+// кадров - в <имя>_sweep.txt рядом.
+class SweepRenderer {
+public:
+    static bool run(const std::vector<std::vector<double>>& depthData, const Config& config);
+
+    // Позиция камеры, повернутая на degrees вокруг camera_up через camera_target
+    static Vector3 orbitCamera(const Config& config, float degrees);
+};
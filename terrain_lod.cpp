@@ -0,0 +1,543 @@
+#include "terrain_lod.h"
+#include "gl_functions.h"
+#include "parallel_utils.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+void TerrainLOD::build(Heightfield source, float sceneScale,
+    std::vector<float> shadow, std::vector<float> occlusion) {
+    release();
+    field = std::move(source);
+    scale = sceneScale;
+    shadowMask = std::move(shadow);
+    occlusionMask = std::move(occlusion);
+    stride = shadowMask.empty() && occlusionMask.empty() ? 6 : 8;
+    if (field.rows < 2 || field.cols < 2) {
+        return;
+    }
+
+    // Ячейки уровня 0 - квады из четырех отсчетов, уровня k - 2x2 ячейки
+    // уровня k-1; уровни добавляются, пока корень не накроет всю карту
+    cellRows.assign(1, field.rows - 1);
+    cellCols.assign(1, field.cols - 1);
+    cellComplete.assign(1, std::vector<bool>(static_cast<size_t>(cellRows[0]) * cellCols[0]));
+    for (int r = 0; r < cellRows[0]; ++r) {
+        for (int c = 0; c < cellCols[0]; ++c) {
+            const size_t v = static_cast<size_t>(r) * field.cols + c;
+            cellComplete[0][static_cast<size_t>(r) * cellCols[0] + c] =
+                field.valid[v] && field.valid[v + 1] && field.valid[v + field.cols] && field.valid[v + field.cols + 1];
+        }
+    }
+    chunkRows.assign(1, (cellRows[0] + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    chunkCols.assign(1, (cellCols[0] + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+    while (chunkRows.back() > 1 || chunkCols.back() > 1) {
+        const int below = static_cast<int>(cellRows.size()) - 1;
+        const int rows = (cellRows[below] + 1) / 2;
+        const int cols = (cellCols[below] + 1) / 2;
+        std::vector<bool> cells(static_cast<size_t>(rows) * cols);
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                cells[static_cast<size_t>(r) * cols + c] = complete(below, 2 * r, 2 * c, 2 * r + 2, 2 * c + 2);
+            }
+        }
+        cellRows.push_back(rows);
+        cellCols.push_back(cols);
+        cellComplete.push_back(std::move(cells));
+        chunkRows.push_back((rows + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        chunkCols.push_back((cols + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    }
+    levels = static_cast<int>(chunkRows.size());
+
+    chunks.resize(levels);
+    for (int level = 0; level < levels; ++level) {
+        chunks[level].assign(static_cast<size_t>(chunkRows[level]) * chunkCols[level], Chunk());
+        computeBounds(level);
+    }
+    leafLevel.assign(static_cast<size_t>(chunkRows[0]) * chunkCols[0], -1);
+}
+
+bool TerrainLOD::complete(int level, int row0, int col0, int row1, int col1) const {
+    // Ячейки [row0, row1) x [col0, col1) уровня; вне карты - только у края
+    if (row0 >= cellRows[level] || col0 >= cellCols[level]) return false;
+    row1 = std::min(row1, cellRows[level]);
+    col1 = std::min(col1, cellCols[level]);
+    for (int r = row0; r < row1; ++r) {
+        for (int c = col0; c < col1; ++c) {
+            if (!cellComplete[level][static_cast<size_t>(r) * cellCols[level] + c]) return false;
+        }
+    }
+    return true;
+}
+
+void TerrainLOD::computeBounds(int level) {
+    const int step = 1 << level;
+    const int half = step / 2;
+    parallelFor(0, chunkRows[level], [&](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            for (int col = 0; col < chunkCols[level]; ++col) {
+                Chunk& chunk = chunks[level][static_cast<size_t>(row) * chunkCols[level] + col];
+                float minZ = std::numeric_limits<float>::infinity();
+                float maxZ = -std::numeric_limits<float>::infinity();
+
+                if (level == 0) {
+                    const int i1 = std::min((row + 1) * CHUNK_SIZE, field.rows - 1);
+                    const int j1 = std::min((col + 1) * CHUNK_SIZE, field.cols - 1);
+                    for (int i = row * CHUNK_SIZE; i <= i1; ++i) {
+                        for (int j = col * CHUNK_SIZE; j <= j1; ++j) {
+                            if (!field.valid[static_cast<size_t>(i) * field.cols + j]) continue;
+                            minZ = std::min(minZ, heightAt(i, j));
+                            maxZ = std::max(maxZ, heightAt(i, j));
+                        }
+                    }
+                    chunk.minZ = minZ;
+                    chunk.maxZ = maxZ;
+                    continue;
+                }
+
+                // Ошибка = отклонение своих треугольников в вершинах детей
+                // (середины ячеек и ребер) + наибольшая ошибка детей
+                float childError = 0.0f;
+                for (int r = 2 * row; r < std::min(2 * row + 2, chunkRows[level - 1]); ++r) {
+                    for (int c = 2 * col; c < std::min(2 * col + 2, chunkCols[level - 1]); ++c) {
+                        const Chunk& child = chunks[level - 1][static_cast<size_t>(r) * chunkCols[level - 1] + c];
+                        minZ = std::min(minZ, child.minZ);
+                        maxZ = std::max(maxZ, child.maxZ);
+                        childError = std::max(childError, child.error);
+                    }
+                }
+
+                // Ячейка с фоном не рисуется целиком: у края объекта теряется
+                // полоса до шага уровня, она тоже считается ошибкой
+                const float edgeError = step * std::max(1.0f / field.cols, 1.0f / field.rows);
+                float deviation = 0.0f;
+                const int cellRow1 = std::min((row + 1) * CHUNK_SIZE, cellRows[level]);
+                const int cellCol1 = std::min((col + 1) * CHUNK_SIZE, cellCols[level]);
+                for (int r = row * CHUNK_SIZE; r < cellRow1; ++r) {
+                    for (int c = col * CHUNK_SIZE; c < cellCol1; ++c) {
+                        const int i0 = r * step, i1 = std::min(i0 + step, field.rows - 1);
+                        const int j0 = c * step, j1 = std::min(j0 + step, field.cols - 1);
+                        const int im = std::min(i0 + half, i1), jm = std::min(j0 + half, j1);
+                        if (!cellComplete[level][static_cast<size_t>(r) * cellCols[level] + c]) {
+                            const int probe[9][2] = { { i0, j0 }, { i0, jm }, { i0, j1 }, { im, j0 }, { im, jm },
+                                { im, j1 }, { i1, j0 }, { i1, jm }, { i1, j1 } };
+                            for (const auto& p : probe) {
+                                if (field.valid[static_cast<size_t>(p[0]) * field.cols + p[1]]) {
+                                    deviation = std::max(deviation, edgeError);
+                                    break;
+                                }
+                            }
+                            continue;
+                        }
+                        const float h00 = heightAt(i0, j0), h01 = heightAt(i0, j1);
+                        const float h10 = heightAt(i1, j0), h11 = heightAt(i1, j1);
+
+                        // Диагональ ячейки v00-v11, как у треугольников фрагмента
+                        auto deviationAt = [&](int i, int j) {
+                            const float v = i1 > i0 ? static_cast<float>(i - i0) / (i1 - i0) : 0.0f;
+                            const float u = j1 > j0 ? static_cast<float>(j - j0) / (j1 - j0) : 0.0f;
+                            const float plane = u >= v
+                                ? h00 + u * (h01 - h00) + v * (h11 - h01)
+                                : h00 + v * (h10 - h00) + u * (h11 - h10);
+                            return fabsf(heightAt(i, j) - plane);
+                        };
+                        deviation = std::max(deviation, deviationAt(im, j0));
+                        deviation = std::max(deviation, deviationAt(i0, jm));
+                        deviation = std::max(deviation, deviationAt(im, jm));
+                        deviation = std::max(deviation, deviationAt(im, j1));
+                        deviation = std::max(deviation, deviationAt(i1, jm));
+                    }
+                }
+                chunk.minZ = minZ;
+                chunk.maxZ = maxZ;
+                chunk.error = deviation + childError;
+            }
+        }
+    }, 1);
+}
+
+void TerrainLOD::upload(int level, int row, int col) {
+    Chunk& chunk = chunks[level][static_cast<size_t>(row) * chunkCols[level] + col];
+    chunk.resident = true;
+    const int step = 1 << level;
+    const int n = CHUNK_SIZE;
+    const int cellRow0 = row * n;
+    const int cellCol0 = col * n;
+
+    // Вершины (n + 1) x (n + 1); за краем карты - последний отсчет
+    std::vector<float> vertices;
+    vertices.reserve(static_cast<size_t>(n + 1) * (n + 1) * stride);
+    for (int a = 0; a <= n; ++a) {
+        const int i = std::min((cellRow0 + a) * step, field.rows - 1);
+        for (int b = 0; b <= n; ++b) {
+            const int j = std::min((cellCol0 + b) * step, field.cols - 1);
+            float nx, ny, nz;
+            field.normal(i, j, nx, ny, nz);
+            vertices.push_back(field.x(j) * scale);
+            vertices.push_back(field.y(i) * scale);
+            vertices.push_back(heightAt(i, j) * scale);
+            vertices.push_back(nx);
+            vertices.push_back(ny);
+            vertices.push_back(nz);
+            if (stride == 8) {
+                const size_t v = static_cast<size_t>(i) * field.cols + j;
+                vertices.push_back(shadowMask.empty() ? 1.0f : shadowMask[v]);
+                vertices.push_back(occlusionMask.empty() ? 1.0f : occlusionMask[v]);
+            }
+        }
+    }
+
+    // Треугольник рисуется, если все ячейки под ним без фона; обход -
+    // против часовой стрелки со стороны +z (x растет с b, y убывает с a)
+    std::vector<uint16_t> indices;
+    auto triangle = [&](int a0, int b0, int a1, int b1, int a2, int b2) {
+        const int rowMin = std::min(a0, std::min(a1, a2)), rowMax = std::max(a0, std::max(a1, a2));
+        const int colMin = std::min(b0, std::min(b1, b2)), colMax = std::max(b0, std::max(b1, b2));
+        const int cross = (a1 - a0) * (b2 - b0) - (b1 - b0) * (a2 - a0);
+        if (cross == 0 || !complete(level, cellRow0 + rowMin, cellCol0 + colMin, cellRow0 + rowMax, cellCol0 + colMax)) {
+            return;
+        }
+        if (cross < 0) {
+            std::swap(a1, a2);
+            std::swap(b1, b2);
+        }
+        indices.push_back(static_cast<uint16_t>(a0 * (n + 1) + b0));
+        indices.push_back(static_cast<uint16_t>(a1 * (n + 1) + b1));
+        indices.push_back(static_cast<uint16_t>(a2 * (n + 1) + b2));
+    };
+
+    // Внутренность: ячейки, не касающиеся края фрагмента
+    for (int a = 1; a < n - 1; ++a) {
+        for (int b = 1; b < n - 1; ++b) {
+            triangle(a, b, a + 1, b + 1, a, b + 1);
+            triangle(a, b, a + 1, b, a + 1, b + 1);
+        }
+    }
+    chunk.first[0] = 0;
+    chunk.count[0] = static_cast<int>(indices.size());
+
+    // Стороны: трапеции между краем (через m ячеек) и внутренним контуром
+    // (через одну), сшитые "молнией" по возрастанию параметра вдоль стороны
+    for (int side = 0; side < 4; ++side) {
+        auto point = [&](int t, int depth, int& a, int& b) {
+            switch (side) {
+            case 0: a = depth; b = t; break;          // верх
+            case 1: a = n - depth; b = t; break;      // низ
+            case 2: a = t; b = depth; break;          // лево
+            default: a = t; b = n - depth; break;     // право
+            }
+        };
+        for (int d = 0; d < SIDE_VARIANTS; ++d) {
+            const int range = 1 + side * SIDE_VARIANTS + d;
+            chunk.first[range] = static_cast<int>(indices.size());
+            const int m = std::min(1 << d, n);
+            const int outerCount = n / m;
+            const int innerCount = n - 2;
+            int p = 0, q = 0;
+            while (p < outerCount || q < innerCount) {
+                int a0, b0, a1, b1, a2, b2;
+                if (q == innerCount || (p < outerCount && (p + 1) * m <= q + 2)) {
+                    point(p * m, 0, a0, b0);
+                    point((p + 1) * m, 0, a1, b1);
+                    point(q + 1, 1, a2, b2);
+                    ++p;
+                }
+                else {
+                    point(p * m, 0, a0, b0);
+                    point(q + 2, 1, a1, b1);
+                    point(q + 1, 1, a2, b2);
+                    ++q;
+                }
+                triangle(a0, b0, a1, b1, a2, b2);
+            }
+            chunk.count[range] = static_cast<int>(indices.size()) - chunk.first[range];
+        }
+    }
+
+    if (indices.empty()) {
+        return;
+    }
+    GLuint buffers[2] = { 0, 0 };
+    GLFunctions::genBuffers(2, buffers);
+    chunk.vertexBuffer = buffers[0];
+    chunk.indexBuffer = buffers[1];
+    GLFunctions::bindBuffer(GL_ARRAY_BUFFER, chunk.vertexBuffer);
+    GLFunctions::bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    GLFunctions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.indexBuffer);
+    GLFunctions::bufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    residentVertices += static_cast<size_t>(n + 1) * (n + 1);
+}
+
+void TerrainLOD::releaseChunk(Chunk& chunk) {
+    if (chunk.vertexBuffer != 0) {
+        const GLuint buffers[] = { chunk.vertexBuffer, chunk.indexBuffer };
+        GLFunctions::deleteBuffers(2, buffers);
+        chunk.vertexBuffer = 0;
+        chunk.indexBuffer = 0;
+        residentVertices -= static_cast<size_t>(CHUNK_SIZE + 1) * (CHUNK_SIZE + 1);
+    }
+    chunk.resident = false;
+}
+
+void TerrainLOD::release() {
+    for (auto& level : chunks) {
+        for (Chunk& chunk : level) {
+            releaseChunk(chunk);
+        }
+    }
+    chunks.clear();
+    cellComplete.clear();
+    cellRows.clear();
+    cellCols.clear();
+    chunkRows.clear();
+    chunkCols.clear();
+    selected.clear();
+    leafLevel.clear();
+    field = Heightfield();
+    shadowMask.clear();
+    occlusionMask.clear();
+    stride = 6;
+    levels = 0;
+    residentVertices = 0;
+    drawnTriangles = 0;
+    culledChunks = 0;
+}
+
+void TerrainLOD::select(float pixelError, int viewportHeight, float fovY) {
+    // Плоскости пирамиды видимости из P * MV (в координатах модели)
+    GLfloat projection[16], modelview[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    float clip[16];
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            clip[c * 4 + r] = projection[r] * modelview[c * 4] + projection[4 + r] * modelview[c * 4 + 1]
+                + projection[8 + r] * modelview[c * 4 + 2] + projection[12 + r] * modelview[c * 4 + 3];
+        }
+    }
+    float planes[6][4];
+    for (int k = 0; k < 6; ++k) {
+        const int axis = k / 2;
+        const float sign = (k % 2 == 0) ? 1.0f : -1.0f;
+        for (int c = 0; c < 4; ++c) {
+            planes[k][c] = clip[c * 4 + 3] + sign * clip[c * 4 + axis];
+        }
+    }
+
+    // Камера в координатах модели: -R^T t
+    float eye[3];
+    for (int k = 0; k < 3; ++k) {
+        eye[k] = -(modelview[k * 4] * modelview[12] + modelview[k * 4 + 1] * modelview[13]
+            + modelview[k * 4 + 2] * modelview[14]);
+    }
+    // У ортографической проекции (P[11] = 0) размер на экране не зависит
+    // от расстояния, пикселей на единицу - из масштаба P[5]
+    const bool orthographic = projection[11] == 0.0f;
+    const float pixelsPerUnit = orthographic ? viewportHeight * projection[5] * 0.5f
+        : viewportHeight / (2.0f * tanf(fovY * 3.14159265f / 360.0f));
+
+    // Спуск от корней: фрагмент рисуется, если его ошибка на экране не
+    // больше pixelError, иначе заменяется четырьмя детьми
+    selected.clear();
+    culledChunks = 0;
+    std::vector<Selection> stack;
+    for (int row = 0; row < chunkRows[levels - 1]; ++row) {
+        for (int col = 0; col < chunkCols[levels - 1]; ++col) {
+            stack.push_back({ levels - 1, row, col });
+        }
+    }
+    while (!stack.empty()) {
+        const Selection node = stack.back();
+        stack.pop_back();
+        const Chunk& chunk = chunks[node.level][static_cast<size_t>(node.row) * chunkCols[node.level] + node.col];
+        if (chunk.minZ > chunk.maxZ) continue;
+
+        const int span = CHUNK_SIZE << node.level;
+        const int i0 = node.row * span, i1 = std::min(i0 + span, field.rows - 1);
+        const int j0 = node.col * span, j1 = std::min(j0 + span, field.cols - 1);
+        const float lo[3] = { field.x(j0) * scale, field.y(i1) * scale, chunk.minZ * scale };
+        const float hi[3] = { field.x(j1) * scale, field.y(i0) * scale, chunk.maxZ * scale };
+
+        bool visible = true;
+        for (int k = 0; k < 6 && visible; ++k) {
+            const float* plane = planes[k];
+            visible = plane[0] * (plane[0] > 0 ? hi[0] : lo[0]) + plane[1] * (plane[1] > 0 ? hi[1] : lo[1])
+                + plane[2] * (plane[2] > 0 ? hi[2] : lo[2]) + plane[3] >= 0.0f;
+        }
+        if (!visible) {
+            ++culledChunks;
+            continue;
+        }
+
+        if (node.level > 0) {
+            float distance2 = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                const float d = eye[k] < lo[k] ? lo[k] - eye[k] : (eye[k] > hi[k] ? eye[k] - hi[k] : 0.0f);
+                distance2 += d * d;
+            }
+            const float distance = orthographic ? 1.0f : sqrtf(distance2);
+            if (chunk.error * scale * pixelsPerUnit > pixelError * distance) {
+                const int below = node.level - 1;
+                for (int r = 2 * node.row; r < std::min(2 * node.row + 2, chunkRows[below]); ++r) {
+                    for (int c = 2 * node.col; c < std::min(2 * node.col + 2, chunkCols[below]); ++c) {
+                        stack.push_back({ below, r, c });
+                    }
+                }
+                continue;
+            }
+        }
+        selected.push_back(node);
+    }
+
+    // Сшивка умеет стороны с соседом грубее не больше чем на
+    // SIDE_VARIANTS - 1 уровней: более грубый фрагмент делится, пока
+    // разница с соседями не станет допустимой
+    for (;;) {
+        fillLeafLevels();
+        std::vector<Selection> balanced;
+        bool split = false;
+        for (const Selection& node : selected) {
+            if (node.level - finestNeighbour(node) < SIDE_VARIANTS) {
+                balanced.push_back(node);
+                continue;
+            }
+            split = true;
+            const int below = node.level - 1;
+            for (int r = 2 * node.row; r < std::min(2 * node.row + 2, chunkRows[below]); ++r) {
+                for (int c = 2 * node.col; c < std::min(2 * node.col + 2, chunkCols[below]); ++c) {
+                    const Chunk& child = chunks[below][static_cast<size_t>(r) * chunkCols[below] + c];
+                    if (child.minZ <= child.maxZ) {
+                        balanced.push_back({ below, r, c });
+                    }
+                }
+            }
+        }
+        selected.swap(balanced);
+        if (!split) break;
+    }
+}
+
+void TerrainLOD::fillLeafLevels() {
+    // Уровни выбранных фрагментов по сетке листьев - для сшивки сторон
+    std::fill(leafLevel.begin(), leafLevel.end(), -1);
+    for (const Selection& node : selected) {
+        const int r1 = std::min((node.row + 1) << node.level, chunkRows[0]);
+        const int c1 = std::min((node.col + 1) << node.level, chunkCols[0]);
+        for (int r = node.row << node.level; r < r1; ++r) {
+            std::fill(leafLevel.begin() + static_cast<size_t>(r) * chunkCols[0] + (node.col << node.level),
+                leafLevel.begin() + static_cast<size_t>(r) * chunkCols[0] + c1, node.level);
+        }
+    }
+}
+
+int TerrainLOD::finestNeighbour(const Selection& node) const {
+    const int r0 = node.row << node.level, c0 = node.col << node.level;
+    const int r1 = std::min((node.row + 1) << node.level, chunkRows[0]);
+    const int c1 = std::min((node.col + 1) << node.level, chunkCols[0]);
+    int finest = node.level;
+    auto visit = [&](int r, int c) {
+        if (r < 0 || r >= chunkRows[0] || c < 0 || c >= chunkCols[0]) return;
+        const int level = leafLevel[static_cast<size_t>(r) * chunkCols[0] + c];
+        if (level >= 0) finest = std::min(finest, level);
+    };
+    for (int c = c0; c < c1; ++c) {
+        visit(r0 - 1, c);
+        visit(r1, c);
+    }
+    for (int r = r0; r < r1; ++r) {
+        visit(r, c0 - 1);
+        visit(r, c1);
+    }
+    return finest;
+}
+
+bool TerrainLOD::prefetch(float pixelError, int viewportHeight, float fovY, int budget) {
+    if (levels == 0) {
+        return true;
+    }
+    select(pixelError, viewportHeight, fovY);
+    bool complete = true;
+    for (const Selection& node : selected) {
+        Chunk& chunk = chunks[node.level][static_cast<size_t>(node.row) * chunkCols[node.level] + node.col];
+        if (chunk.resident) continue;
+        if (budget-- <= 0) {
+            complete = false;
+            break;
+        }
+        upload(node.level, node.row, node.col);
+    }
+    return complete;
+}
+
+void TerrainLOD::draw(float pixelError, int viewportHeight, float fovY) {
+    if (levels == 0) {
+        return;
+    }
+    ++frame;
+    select(pixelError, viewportHeight, fovY);
+    auto neighbourLevel = [&](int r, int c) {
+        if (r < 0 || r >= chunkRows[0] || c < 0 || c >= chunkCols[0]) return -1;
+        return leafLevel[static_cast<size_t>(r) * chunkCols[0] + c];
+    };
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    if (stride == 8) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+    else {
+        glTexCoord2f(1.0f, 1.0f); // без теней и AO: все освещено и открыто
+    }
+    drawnTriangles = 0;
+    for (const Selection& node : selected) {
+        Chunk& chunk = chunks[node.level][static_cast<size_t>(node.row) * chunkCols[node.level] + node.col];
+        if (!chunk.resident) {
+            upload(node.level, node.row, node.col);
+        }
+        chunk.lastFrame = frame;
+        if (chunk.vertexBuffer == 0) continue;
+
+        const int r0 = node.row << node.level, c0 = node.col << node.level;
+        const int r1 = (node.row + 1) << node.level, c1 = (node.col + 1) << node.level;
+        const int neighbours[4] = {
+            neighbourLevel(r0 - 1, c0), neighbourLevel(r1, c0), neighbourLevel(r0, c0 - 1), neighbourLevel(r0, c1)
+        };
+        int ranges[5] = { 0 };
+        for (int side = 0; side < 4; ++side) {
+            const int d = std::min(std::max(neighbours[side] - node.level, 0), SIDE_VARIANTS - 1);
+            ranges[side + 1] = 1 + side * SIDE_VARIANTS + d;
+        }
+
+        GLFunctions::bindBuffer(GL_ARRAY_BUFFER, chunk.vertexBuffer);
+        GLFunctions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.indexBuffer);
+        glVertexPointer(3, GL_FLOAT, stride * sizeof(float), nullptr);
+        glNormalPointer(GL_FLOAT, stride * sizeof(float), reinterpret_cast<const void*>(3 * sizeof(float)));
+        if (stride == 8) {
+            glTexCoordPointer(2, GL_FLOAT, stride * sizeof(float), reinterpret_cast<const void*>(6 * sizeof(float)));
+        }
+        for (int range : ranges) {
+            if (chunk.count[range] == 0) continue;
+            glDrawElements(GL_TRIANGLES, chunk.count[range], GL_UNSIGNED_SHORT,
+                reinterpret_cast<const void*>(chunk.first[range] * sizeof(uint16_t)));
+            drawnTriangles += chunk.count[range] / 3;
+        }
+    }
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    GLFunctions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLFunctions::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Сверх бюджета освобождаются фрагменты, не нужные в этом кадре
+    if (residentVertices > RESIDENT_VERTICES) {
+        for (auto& level : chunks) {
+            for (Chunk& chunk : level) {
+                if (chunk.resident && chunk.lastFrame < frame) {
+                    releaseChunk(chunk);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "heightfield.h"
+#include <vector>
+#include <cstdint>
+
+// Поле высот для OpenGL-окна как квадродерево фрагментов (chunked LOD).
+// Фрагмент уровня k - сетка CHUNK_SIZE x CHUNK_SIZE ячеек с шагом 2^k
+// отсчетов, листья (k = 0) - полное разрешение. На кадр выбираются
+// фрагменты внутри пирамиды видимости, чья геометрическая ошибка на экране
+// не больше заданной в пикселях, поэтому число треугольников зависит от
+// размера окна, а не карты. Сторона фрагмента, граничащая с более грубым
+// соседом, строится с шагом соседа (сшивка без трещин и T-стыков).
+// Буферы фрагментов создаются при первом выборе, давно не нужные
+// освобождаются при превышении бюджета вершин.
+class TerrainLOD {
+public:
+    static const int CHUNK_SIZE = 64;
+
+    // Высоты поля без масштаба; scale - масштаб сцены окна. Без вызовов GL,
+    // можно выполнять в рабочем потоке. Маски теней и AO по отсчетам (могут
+    // быть пустыми) попадают в вершины как текстурные координаты (s, t)
+    void build(Heightfield field, float scale,
+        std::vector<float> shadowMask = {}, std::vector<float> occlusionMask = {});
+    // Освобождает буферы; нужен текущий контекст GL
+    void release();
+    bool empty() const { return levels == 0; }
+
+    // Выбор и отрисовка фрагментов при текущих матрицах GL_PROJECTION и
+    // GL_MODELVIEW (вращения и сдвиги, без масштабирования). fovY - угол
+    // перспективы; ортографическая проекция распознается по матрице
+    void draw(float pixelError, int viewportHeight, float fovY);
+
+    // Выбор фрагментов для текущего вида и загрузка не больше budget
+    // недостающих буферов, без отрисовки. true - все выбранные готовы
+    bool prefetch(float pixelError, int viewportHeight, float fovY, int budget);
+
+    int getLevels() const { return levels; }
+    int getDrawnChunks() const { return static_cast<int>(selected.size()); }
+    int getDrawnTriangles() const { return drawnTriangles; }
+    // Фрагменты (с поддеревьями), отброшенные пирамидой видимости
+    int getCulledChunks() const { return culledChunks; }
+
+private:
+    // Сторона, граничащая с соседом грубее на d уровней, строится с шагом
+    // 2^d своих ячеек, d = 0..log2(CHUNK_SIZE); выбор фрагментов не
+    // допускает соседей, различающихся больше чем на SIDE_VARIANTS - 1
+    static const int SIDE_VARIANTS = 7;
+    static const int RANGES = 1 + 4 * SIDE_VARIANTS; // внутренность и стороны
+    static const size_t RESIDENT_VERTICES = 8u << 20;
+
+    struct Chunk {
+        float error = 0.0f;              // отклонение от полного разрешения, единицы поля
+        float minZ = 0.0f, maxZ = -1.0f; // высоты отсчетов без фона; minZ > maxZ - пустой
+        unsigned int vertexBuffer = 0;   // x, y, z, nx, ny, nz[, свет, фон]
+        unsigned int indexBuffer = 0;
+        int first[RANGES] = {};
+        int count[RANGES] = {};
+        bool resident = false;           // буферы построены (или фрагмент без треугольников)
+        long long lastFrame = -1;
+    };
+
+    struct Selection {
+        int level, row, col;
+    };
+
+    Heightfield field;
+    float scale = 1.0f;
+    std::vector<float> shadowMask, occlusionMask;
+    int stride = 6;                                 // float на вершину
+    int levels = 0;
+    std::vector<int> cellRows, cellCols;            // ячеек на уровне
+    std::vector<std::vector<bool>> cellComplete;    // ячейка уровня без фона
+    std::vector<int> chunkRows, chunkCols;          // фрагментов на уровне
+    std::vector<std::vector<Chunk>> chunks;
+
+    std::vector<Selection> selected;
+    std::vector<int> leafLevel;   // уровень выбранного фрагмента над листом, -1 - не рисуется
+    long long frame = 0;
+    size_t residentVertices = 0;
+    int drawnTriangles = 0;
+    int culledChunks = 0;
+
+    float heightAt(int i, int j) const { return field.height[static_cast<size_t>(i) * field.cols + j]; }
+    bool complete(int level, int row0, int col0, int row1, int col1) const;
+    void computeBounds(int level);
+    void select(float pixelError, int viewportHeight, float fovY);
+    void fillLeafLevels();
+    // Наименьший уровень выбранных фрагментов, граничащих с node
+    int finestNeighbour(const Selection& node) const;
+    void upload(int level, int row, int col);
+    void releaseChunk(Chunk& chunk);
+};
@@ -0,0 +1,161 @@
+#include "viewer_mesh.h"
+#include "gl_functions.h"
+#include "heightfield.h"
+#include "depth_reader.h"
+#include <iostream>
+#include <chrono>
+
+void ViewerMesh::release() {
+    terrain.release();
+    if (displayList != 0) {
+        glDeleteLists(displayList, 1);
+        displayList = 0;
+    }
+}
+
+ViewerMeshBuilder::~ViewerMeshBuilder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.reset();
+    }
+    cv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ViewerMeshBuilder::request(std::vector<std::vector<double>> depthData, const Config& config,
+    float scale, bool lod) {
+    std::unique_ptr<Request> next(new Request{ std::move(depthData), config, scale, lod });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = std::move(next);
+        if (!worker.joinable()) {
+            worker = std::thread(&ViewerMeshBuilder::loop, this);
+        }
+    }
+    cv.notify_all();
+}
+
+std::unique_ptr<ViewerMesh> ViewerMeshBuilder::take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::move(ready);
+}
+
+bool ViewerMeshBuilder::busy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return building || pending != nullptr;
+}
+
+std::unique_ptr<ViewerMesh> ViewerMeshBuilder::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return !building && pending == nullptr; });
+    return std::move(ready);
+}
+
+void ViewerMeshBuilder::loop() {
+    for (;;) {
+        std::unique_ptr<Request> current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return pending != nullptr || stopping; });
+            if (stopping) return;
+            current = std::move(pending);
+            building = true;
+        }
+
+        std::unique_ptr<ViewerMesh> mesh = build(*current);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            building = false;
+            // Неудачная сборка (например, файл еще дописывается) не заменяет готовую
+            if (mesh) {
+                ready = std::move(mesh);
+            }
+        }
+        cv.notify_all();
+    }
+}
+
+std::unique_ptr<ViewerMesh> ViewerMeshBuilder::build(Request& request) {
+    const auto start = std::chrono::steady_clock::now();
+    if (request.depthData.empty()) {
+        DepthReader reader;
+        if (!reader.readDepthMap(request.config.depth_map_file)) {
+            std::cerr << "Ошибка перезагрузки карты глубины " << request.config.depth_map_file << std::endl;
+            return nullptr;
+        }
+        request.depthData = reader.getDepthData();
+    }
+    if (request.depthData.size() < 2 || request.depthData[0].size() < 2) {
+        std::cerr << "Ошибка: карта глубины слишком мала для сетки" << std::endl;
+        return nullptr;
+    }
+
+    // Высоты без config.scale, нормали общие для соседних квадов
+    std::unique_ptr<ViewerMesh> mesh(new ViewerMesh());
+    Heightfield field = Heightfield::fromDepth(request.depthData, 1.0f);
+    request.depthData.clear();
+    request.depthData.shrink_to_fit();
+    mesh->rows = field.rows;
+    mesh->cols = field.cols;
+
+    // Тени считаются один раз: источник в окне не перемещается
+    if (request.config.shadows) {
+        HeightfieldLighting::shadowMask(field, request.config.light_direction, mesh->shadowMask);
+    }
+    if (request.config.ambient_occlusion) {
+        HeightfieldLighting::ambientOcclusion(field, request.config.ao_directions,
+            request.config.ao_radius, mesh->occlusionMask);
+    }
+
+    if (request.lod) {
+        // Тени и AO уходят в вершины фрагментов (учитываются шейдером)
+        mesh->terrain.build(std::move(field), request.scale,
+            std::move(mesh->shadowMask), std::move(mesh->occlusionMask));
+        mesh->shadowMask.clear();
+        mesh->occlusionMask.clear();
+    }
+    else {
+        const int height = field.rows;
+        const int width = field.cols;
+        std::vector<int32_t> remap(static_cast<size_t>(width) * height, -1);
+        int32_t next = 0;
+        for (int i = 0; i < height; ++i) {
+            for (int j = 0; j < width; ++j) {
+                const size_t v = static_cast<size_t>(i) * width + j;
+                if (!field.valid[v]) continue;
+                remap[v] = next++;
+
+                float nx, ny, nz;
+                field.normal(i, j, nx, ny, nz);
+                mesh->vertices.push_back(field.x(j) * request.scale);
+                mesh->vertices.push_back(field.y(i) * request.scale);
+                mesh->vertices.push_back(field.height[v] * request.scale);
+                mesh->vertices.push_back(nx);
+                mesh->vertices.push_back(ny);
+                mesh->vertices.push_back(nz);
+            }
+        }
+
+        // Два треугольника на квад без фона, против часовой стрелки со стороны +z
+        for (int i = 0; i < height - 1; ++i) {
+            for (int j = 0; j < width - 1; ++j) {
+                const size_t v00 = static_cast<size_t>(i) * width + j;
+                const size_t quad[6] = { v00, v00 + width + 1, v00 + 1, v00, v00 + width, v00 + width + 1 };
+                if ((remap[quad[0]] | remap[quad[1]] | remap[quad[2]] | remap[quad[4]]) < 0) continue;
+                for (size_t v : quad) {
+                    mesh->indices.push_back(static_cast<uint32_t>(remap[v]));
+                    mesh->samples.push_back(v);
+                }
+            }
+        }
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Сетка окна собрана в фоне: " << mesh->cols << "x" << mesh->rows << ", " << ms << " мс" << std::endl;
+    return mesh;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "config_reader.h"
+#include "terrain_lod.h"
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Сетка OpenGL-окна для одной карты глубины. Все, что не требует
+// контекста GL, готовит ViewerMeshBuilder в рабочем потоке; буферы
+// фрагментов и список отображения создаются в потоке окна.
+struct ViewerMesh {
+    int rows = 0, cols = 0;
+    TerrainLOD terrain;                  // фрагменты LOD, если есть VBO (с тенями/AO - и шейдеры)
+
+    // Полная сетка для списка отображения (материал в каждой вершине)
+    std::vector<float> vertices;         // x, y, z, nx, ny, nz
+    std::vector<uint32_t> indices;
+    std::vector<size_t> samples;         // отсчет карты для каждого индекса
+    std::vector<float> shadowMask;       // по отсчетам карты, пусто без теней
+    std::vector<float> occlusionMask;    // по отсчетам карты, пусто без AO
+    unsigned int displayList = 0;
+    int listTriangles = 0;
+
+    bool empty() const { return terrain.empty() && indices.empty() && displayList == 0; }
+    // Освобождает объекты GL; вызывается в потоке окна
+    void release();
+};
+
+// Сборка сетки окна в одном фоновом потоке. Новая заявка заменяет еще не
+// начатую, готовая сетка ждет, пока окно ее заберет.
+class ViewerMeshBuilder {
+public:
+    ~ViewerMeshBuilder();
+
+    // depthData пуста - карта заново читается из config.depth_map_file.
+    // lod - строить фрагменты LOD (иначе полную сетку для списка отображения)
+    void request(std::vector<std::vector<double>> depthData, const Config& config,
+        float scale, bool lod);
+
+    // Готовая сетка или nullptr; не блокирует
+    std::unique_ptr<ViewerMesh> take();
+    bool busy();
+    // Ждет окончания сборки; nullptr - сборка не удалась
+    std::unique_ptr<ViewerMesh> wait();
+
+private:
+    struct Request {
+        std::vector<std::vector<double>> depthData;
+        Config config;
+        float scale;
+        bool lod;
+    };
+
+    void loop();
+    static std::unique_ptr<ViewerMesh> build(Request& request);
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unique_ptr<Request> pending;
+    std::unique_ptr<ViewerMesh> ready;
+    bool building = false;
+    bool stopping = false;
+};